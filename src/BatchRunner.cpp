@@ -0,0 +1,216 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "BatchRunner.hpp"
+
+#include "Renderer.hpp"
+#include "io/JSONWriter.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+BatchRunner::BatchRunner(std::string fname) : fname(fname), failures(0) {
+    threadBudget = std::thread::hardware_concurrency() != 0 ? std::thread::hardware_concurrency() : 4;
+    freeThreads = threadBudget;
+}
+
+int BatchRunner::readJobs() {
+    std::ifstream file;
+    file.open(fname);
+
+    if (!file) {
+        std::cout << "Failed to open batch file " << fname << std::endl;
+        return 1;
+    }
+
+    std::string line;
+    unsigned int lineNumber = 0;
+
+    while (std::getline(file, line, '\n')) {
+        ++lineNumber;
+
+        std::vector<std::string> args = splitArguments(line);
+        if (args.empty() || args[0][0] == '#')
+            continue;
+
+        Options job;
+        if (parseOptions(args, &job) != 0 || job.batch || job.serve || job.estimate) {
+            std::cout << "Skipping invalid job on line " << lineNumber << " of " << fname << std::endl;
+            ++failures;
+            continue;
+        }
+
+        // there is no window to show a batch job in, so every job is saved
+        if (!job.save) {
+            job.save = true;
+            job.saveFileName = "buddhabrot_" + std::to_string(lineNumber);
+        }
+
+        bool grouped = false;
+        for (JobGroup &group : groups) {
+            if (sameHistogram(group.jobs[0], job)) {
+                group.jobs.push_back(job);
+                grouped = true;
+                break;
+            }
+        }
+
+        if (!grouped) {
+            JobGroup group;
+            group.jobs.push_back(job);
+            group.cost = job.load ? 0.0 : (double)job.config.windowWidth * job.config.height() * job.config.iterations;
+            groups.push_back(group);
+        }
+    }
+
+    file.close();
+
+    return 0;
+}
+
+void BatchRunner::runGroup(JobGroup *group, unsigned int numThreads) {
+    Options &first = group->jobs[0];
+
+    RenderConfig config = first.config;
+    if (!first.threadsGiven)
+        config.numThreads = numThreads;
+
+    Renderer renderer(config);
+
+    int err = first.load ? renderer.load(first.loadFileName) : renderer.render();
+
+    if (err == 0) {
+        // every job's statistics are the render's followed by its own save, leaving out the saves of the jobs
+        // before it
+        const Statistics rendered = *renderer.getStatistics();
+        const double renderSeconds = Statistics::now() - rendered.startTime;
+
+        for (Options &job : group->jobs) {
+            const Statistics before = *renderer.getStatistics();
+            const double saveStart = Statistics::now();
+
+            // only the way the histogram is drawn differs between jobs of a group
+            if (renderer.save(job.saveFileName, job.config) != 0)
+                err = 1;
+
+            if (job.stats) {
+                Statistics stats = rendered;
+
+                for (const std::pair<std::string, double> &p : renderer.getStatistics()->phases) {
+                    const double seconds = p.second - before.phase(p.first);
+                    if (seconds > 0)
+                        stats.addPhase(p.first, seconds);
+                }
+
+                stats.aggregate();
+                stats.wallSeconds = renderSeconds + (Statistics::now() - saveStart);
+
+                JSONWriter json(job.statsFileName);
+                if (json.write(&stats) != 0)
+                    std::cout << "Failed to save statistics to " << job.statsFileName << std::endl;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (err != 0)
+        failures += group->jobs.size();
+}
+
+void BatchRunner::runCPUGroups(std::vector<JobGroup*> cpuGroups) {
+    // largest first so that the long jobs are not left running alone at the end
+    std::sort(cpuGroups.begin(), cpuGroups.end(), [](const JobGroup *a, const JobGroup *b) { return a->cost > b->cost; });
+
+    std::vector<std::thread> workers;
+
+    for (unsigned int i = 0; i < cpuGroups.size(); ++i) {
+        unsigned int numThreads;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            threadsReturned.wait(lock, [this]() { return freeThreads > 0; });
+
+            // share what is free between the groups still waiting, so many small jobs each get a single thread
+            // and run side by side, while the last few get to use every core
+            unsigned int waiting = cpuGroups.size() - i;
+            numThreads = std::max(1u, freeThreads / waiting);
+            freeThreads -= numThreads;
+        }
+
+        JobGroup *group = cpuGroups[i];
+
+        workers.push_back(std::thread([this, group, numThreads]() {
+            runGroup(group, numThreads);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            freeThreads += numThreads;
+            threadsReturned.notify_all();
+        }));
+    }
+
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+int BatchRunner::run() {
+    if (readJobs() != 0)
+        return 1;
+
+    unsigned int jobCount = 0;
+    std::vector<JobGroup*> cpuGroups;
+    std::vector<JobGroup*> gpuGroups;
+
+    for (JobGroup &group : groups) {
+        jobCount += group.jobs.size();
+
+        // hybrid jobs open the device as well, so share the OpenCL lane rather than run alongside its jobs
+        if (group.jobs[0].config.usesOpenCL())
+            gpuGroups.push_back(&group);
+        else
+            cpuGroups.push_back(&group);
+    }
+
+    std::cout << "Running " << jobCount << " jobs as " << groups.size() << " calculations (" << gpuGroups.size() << " OpenCL, " << cpuGroups.size() << " CPU) from " << fname << std::endl;
+
+    // the OpenCL groups barely use the host, so they run on their own thread alongside the CPU groups. Hybrid
+    // groups do use the host for their share of the rows, so take half of the threads that are free from the CPU
+    // groups' budget while they run
+    std::thread gpuLane([this, gpuGroups]() {
+        for (JobGroup *group : gpuGroups) {
+            unsigned int numThreads = 1;
+
+            if (group->jobs[0].config.hybrid) {
+                std::unique_lock<std::mutex> lock(mutex);
+                threadsReturned.wait(lock, [this]() { return freeThreads > 0; });
+
+                numThreads = std::max(1u, freeThreads / 2);
+                freeThreads -= numThreads;
+            }
+
+            runGroup(group, numThreads);
+
+            if (group->jobs[0].config.hybrid) {
+                std::lock_guard<std::mutex> lock(mutex);
+                freeThreads += numThreads;
+                threadsReturned.notify_all();
+            }
+        }
+    });
+
+    runCPUGroups(cpuGroups);
+
+    gpuLane.join();
+
+    std::cout << "Finished batch with " << failures << " failed jobs" << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Options.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef BatchRunner_hpp
+#define BatchRunner_hpp
+
+// renders every job of a batch file in one process. Jobs whose histograms would be identical, i.e that only
+// differ in colour, alpha or output names, are grouped so the fractal is only calculated once and then saved
+// once per job. OpenCL groups run one after another, as they share the device and its compiled kernels, while
+// CPU groups run alongside each other sharing out the hardware threads
+class BatchRunner {
+private:
+    struct JobGroup {
+        std::vector<Options> jobs;
+        double cost;
+    };
+
+    std::string fname;
+
+    std::vector<JobGroup> groups;
+
+    unsigned int threadBudget;
+    unsigned int freeThreads;
+    unsigned int failures;
+
+    std::mutex mutex;
+    std::condition_variable threadsReturned;
+
+    int readJobs();
+    void runGroup(JobGroup *group, unsigned int numThreads);
+    void runCPUGroups(std::vector<JobGroup*> cpuGroups);
+
+public:
+    BatchRunner(std::string fname);
+
+    int run();
+};
+
+#endif // BatchRunner_hpp
@@ -0,0 +1,69 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "ChunkQueue.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+unsigned int ChunkQueue::addConsumer(unsigned int initialRows) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    consumers.push_back({ std::max(initialRows, 1u), 0 });
+
+    return (unsigned int)consumers.size() - 1;
+}
+
+bool ChunkQueue::take(unsigned int consumer, unsigned int *first, unsigned int *count) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (next >= rows)
+        return false;
+
+    const unsigned int remaining = rows - next;
+    const Consumer &taker = consumers[consumer];
+
+    unsigned int size = taker.initialRows;
+
+    if (taker.rowsPerSecond > 0) {
+        // consumers yet to finish a chunk are left out of the total, so early shares come out a little large
+        double totalRate = 0;
+        for (const Consumer &other : consumers)
+            totalRate += other.rowsPerSecond;
+
+        // half of its share of the rows left, so that the last chunks get smaller and smaller
+        const double share = remaining * taker.rowsPerSecond / totalRate / 2;
+
+        size = (unsigned int)std::max(1.0, floor(std::min(taker.rowsPerSecond * CHUNK_SECONDS, share)));
+    }
+
+    *first = next;
+    *count = std::min(size, remaining);
+
+    next += *count;
+
+    return true;
+}
+
+void ChunkQueue::finished(unsigned int consumer, unsigned int count, double seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // averaged with the chunks before, whose weight halves with every chunk, so that it follows the cost of rows
+    // changing across the grid without being thrown by a single expensive row
+    const double rate = count / std::max(seconds, 1E-6);
+    double &average = consumers[consumer].rowsPerSecond;
+
+    average = average > 0 ? (average + rate) / 2 : rate;
+}
+
+double ChunkQueue::rate(unsigned int consumer) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return consumers[consumer].rowsPerSecond;
+}
@@ -0,0 +1,53 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include <mutex>
+#include <vector>
+
+#ifndef ChunkQueue_hpp
+#define ChunkQueue_hpp
+
+// how long a chunk should take its consumer, long enough that an OpenCL chunk is mostly spent in the kernels
+static const double CHUNK_SECONDS = 0.25;
+
+// hands out the rows of the seed grid, in chunks of consecutive rows, to consumers as different as CPU workers and
+// an OpenCL device, each taking its next chunk as soon as it finishes the last. Every consumer's throughput is
+// measured from the chunks it finishes, its next chunk being sized to take CHUNK_SECONDS, and shrunk towards the
+// end to its share of the rows left so that every consumer finishes at about the same time
+class ChunkQueue {
+private:
+    struct Consumer {
+        unsigned int initialRows;
+        double rowsPerSecond; // 0 until it finishes a chunk
+    };
+
+    std::mutex mutex;
+
+    unsigned int next;
+    unsigned int rows;
+
+    std::vector<Consumer> consumers;
+
+public:
+    ChunkQueue(unsigned int rows) : next(0), rows(rows) {};
+
+    // returns the id of a new consumer, whose first chunk is initialRows long
+    unsigned int addConsumer(unsigned int initialRows);
+
+    // the next chunk for consumer, false once every row has been handed out
+    bool take(unsigned int consumer, unsigned int *first, unsigned int *count);
+
+    // consumer finished a chunk of count rows in seconds
+    void finished(unsigned int consumer, unsigned int count, double seconds);
+
+    // rows per second measured for consumer
+    double rate(unsigned int consumer);
+};
+
+#endif // ChunkQueue_hpp
@@ -1,6 +1,6 @@
 //===========================================================================//
 ///
-/// Copyright Jim Carty © 2020
+/// Copyright Jim Carty © 2020-2021
 ///
 /// This file is subject to the terms and conditions defined in file
 /// 'LICENSE.txt', which is part of this source code package.
@@ -11,19 +11,13 @@
 
 #include <math.h>
 
-ComplexNumber ComplexNumber::operator+(const ComplexNumber &c) {
-    real = real + c.real;
-    imag = imag + c.imag;
-	return *this;
+long double ComplexNumber::abs() const {
+	return hypot(real, imag);
 }
 
-ComplexNumber ComplexNumber::operator*(const ComplexNumber &c) {
-    long double oldReal = real;
-    real = real * c.real - imag * c.imag;
-    imag = 2 * oldReal * imag;
-	return *this;
-}
+ComplexNumber ComplexNumber::pow(long double degree) const {
+	long double r = powl(norm(), degree / 2);
+	long double theta = atan2l(imag, real) * degree;
 
-long double ComplexNumber::abs() {
-	return hypot(real, imag);
+	return ComplexNumber(r * cosl(theta), r * sinl(theta));
 }
@@ -1,6 +1,6 @@
 //===========================================================================//
 ///
-/// Copyright Jim Carty © 2020
+/// Copyright Jim Carty © 2020-2021
 ///
 /// This file is subject to the terms and conditions defined in file
 /// 'LICENSE.txt', which is part of this source code package.
@@ -17,10 +17,17 @@ struct ComplexNumber {
 	ComplexNumber() : real(0), imag(0) {};
 	ComplexNumber(long double real, long double imag) : real(real), imag(imag) {};
 
-	ComplexNumber operator+(const ComplexNumber &c);
-	ComplexNumber operator*(const ComplexNumber &c);
+	// defined here so that the escape loops can inline them
+	inline ComplexNumber operator+(const ComplexNumber &c) const { return ComplexNumber(real + c.real, imag + c.imag); };
+	inline ComplexNumber operator*(const ComplexNumber &c) const { return ComplexNumber(real * c.real - imag * c.imag, real * c.imag + imag * c.real); };
 
-	long double abs();
+	inline ComplexNumber square() const { return ComplexNumber(real * real - imag * imag, 2 * real * imag); };
+	inline long double norm() const { return real * real + imag * imag; };
+
+	long double abs() const;
+
+	// principal value of z^degree, through the polar form
+	ComplexNumber pow(long double degree) const;
 };
 
 #endif // ComplexNumber_hpp
@@ -1,105 +1,330 @@
 //===========================================================================//
 ///
-/// Copyright Jim Carty © 2020
+/// Copyright Jim Carty © 2020-2021
 ///
 /// This file is subject to the terms and conditions defined in file
 /// 'LICENSE.txt', which is part of this source code package.
 ///
 //===========================================================================//
 
-#ifndef CELLS_CURRENT
-    #define CELLS_CURRENT 0lu
+#ifndef WIDTH
+    #define WIDTH 0
 #endif
 
-#ifndef CELLS_PER_ROW
-    #define CELLS_PER_ROW 0lu
+// degree of z = z^DEGREE + c. Whole degrees are given as POWER so that they can be unrolled, otherwise POWER is 0
+// and the polar form is used
+#ifndef POWER
+    #define POWER 2
 #endif
 
-#if defined(cl_khr_fp64)
-    #pragma OPENCL EXTENSION cl_khr_fp64 : enable
-    #define DOUBLE_SUPPORT_AVAILABLE
-#elif defined(cl_amd_fp64)
-    #pragma OPENCL EXTENSION cl_amd_fp64 : enable
-    #define DOUBLE_SUPPORT_AVAILABLE
+#ifndef DEGREE
+    #define DEGREE POWER
 #endif
 
-#if defined(DOUBLE_SUPPORT_AVAILABLE)
+#ifndef BAILOUT_SQUARED
+    #define BAILOUT_SQUARED 4.0
+#endif
+
+// stop orbits that have settled into a cycle
+#ifndef CYCLES
+    #define CYCLES 1
+#endif
+
+// projected views binned after the viewport by the count pass, each one a band of the same size
+#ifndef VIEWS
+    #define VIEWS 0
+#endif
+
+// precision of the kernel, chosen by the host from what the device supports. DOUBLE needs cl_khr_fp64 or
+// cl_amd_fp64, and FLOAT_FLOAT carries every value as the unevaluated sum of two floats, for close to double's
+// precision on devices without fp64 or with only slow fp64. Otherwise floats are used
+#ifndef DOUBLE
+    #define DOUBLE 0
+#endif
+
+#ifndef FLOAT_FLOAT
+    #define FLOAT_FLOAT 0
+#endif
+
+#if DOUBLE
+    #if defined(cl_khr_fp64)
+        #pragma OPENCL EXTENSION cl_khr_fp64 : enable
+    #elif defined(cl_amd_fp64)
+        #pragma OPENCL EXTENSION cl_amd_fp64 : enable
+    #endif
+
     // double
     typedef double Real;
+    typedef double Scalar;
+    #define REAL_EPSILON DBL_EPSILON
+#elif FLOAT_FLOAT
+    // float-float, the leading float in x and the rounding error it leaves in y
+    typedef float2 Real;
+    typedef float Scalar;
+    #define REAL_EPSILON (FLT_EPSILON * FLT_EPSILON)
+
+    // the error-free transformations below rely on every operation being rounded on its own
+    #pragma OPENCL FP_CONTRACT OFF
 #else
     // float
     typedef float Real;
+    typedef float Scalar;
+    #define REAL_EPSILON FLT_EPSILON
 #endif
 
+// the check pass' output for a seed holds whether it contributes in the top bit and how many times its orbit has
+// been advanced in the bits below, so that the host can group seeds of similar cost for the count pass
+#define CHECK_CONTRIBUTES 0x80000000u
+#define CHECK_LENGTH 0x7FFFFFFFu
 
-kernel void escape(global Real *originalCells, global Real *currentCells, const Real minx, const Real miny, const Real cellRealWidth, const unsigned int iterationsCurrent, volatile global Real *interimResults, volatile global unsigned int *counts) {
+// an orbit that comes back to within this of a point it has already been through has settled into a cycle, a few
+// rounding errors of the precision it is iterated in
+#define CYCLE_TOLERANCE_SQUARED ((16 * REAL_EPSILON) * (16 * REAL_EPSILON))
 
-    private unsigned int count = get_global_id(0);
+#if FLOAT_FLOAT
+// a + b exactly, as the rounded sum and its rounding error
+inline float2 twoSum(const float a, const float b) {
+    private float sum = a + b;
+    private float b2 = sum - a;
 
-    if (count <= CELLS_CURRENT) {
+    return (float2)(sum, (a - (sum - b2)) + (b - b2));
+}
 
-        private int x = count / CELLS_PER_ROW;
-        private int y = count % CELLS_PER_ROW;
+// a + b exactly, when |a| >= |b|
+inline float2 quickTwoSum(const float a, const float b) {
+    private float sum = a + b;
 
-#if CHECK
-        private Real zreal = currentCells[x * CELLS_PER_ROW * 2 + y * 2 + 0],
-            zimag = currentCells[x * CELLS_PER_ROW * 2 + y * 2 + 1];
+    return (float2)(sum, b - (sum - a));
+}
+
+// a * b exactly, as the rounded product and its rounding error
+inline float2 twoProduct(const float a, const float b) {
+    private float product = a * b;
 
-        private Real creal = originalCells[x * CELLS_PER_ROW * 2 + y * 2 + 0],
-            cimag = originalCells[x * CELLS_PER_ROW * 2 + y * 2 + 1];
+    return (float2)(product, fma(a, b, -product));
+}
 
+inline Real addReal(const Real a, const Real b) {
+    private float2 high = twoSum(a.x, b.x);
+    private float2 low = twoSum(a.y, b.y);
+
+    high.y += low.x;
+    high = quickTwoSum(high.x, high.y);
+    high.y += low.y;
+
+    return quickTwoSum(high.x, high.y);
+}
+
+inline Real subReal(const Real a, const Real b) {
+    return addReal(a, -b);
+}
+
+inline Real mulReal(const Real a, const Real b) {
+    private float2 product = twoProduct(a.x, b.x);
+    product.y += a.x * b.y + a.y * b.x;
+
+    return quickTwoSum(product.x, product.y);
+}
+
+inline Scalar leading(const Real a) {
+    return a.x;
+}
+
+inline Real toReal(const Scalar a) {
+    return (float2)(a, 0);
+}
 #else
+inline Real addReal(const Real a, const Real b) {
+    return a + b;
+}
+
+inline Real subReal(const Real a, const Real b) {
+    return a - b;
+}
+
+inline Real mulReal(const Real a, const Real b) {
+    return a * b;
+}
+
+inline Scalar leading(const Real a) {
+    return a;
+}
+
+inline Real toReal(const Scalar a) {
+    return a;
+}
+#endif
+
+// |z|^2, only to the precision of the leading part
+inline Scalar norm(const Real zreal, const Real zimag) {
+    return leading(zreal) * leading(zreal) + leading(zimag) * leading(zimag);
+}
+
+// z = z^DEGREE + c
+inline void advance(private Real *zreal, private Real *zimag, const Real creal, const Real cimag) {
+#if POWER == 2
+    // z = z^2 + c
+    private Real oldReal = *zreal;
+    *zreal = subReal(mulReal(*zreal, *zreal), mulReal(*zimag, *zimag));
+    *zimag = mulReal(2 * oldReal, *zimag);
+#elif POWER > 2
+    // z = z^POWER + c, unrolled as POWER is known when the kernel is built
+    private Real powerReal = *zreal,
+        powerImag = *zimag;
+
+    #pragma unroll
+    for (private int k = 1; k < POWER; ++k) {
+        private Real oldReal = powerReal;
+        powerReal = subReal(mulReal(oldReal, *zreal), mulReal(powerImag, *zimag));
+        powerImag = addReal(mulReal(oldReal, *zimag), mulReal(powerImag, *zreal));
+    }
+
+    *zreal = powerReal;
+    *zimag = powerImag;
+#else
+    // z = z^DEGREE + c, through the polar form, which float-float only works out from the leading floats
+    private Scalar modulus = pow(norm(*zreal, *zimag), (Scalar)DEGREE * (Scalar)0.5);
+    private Scalar argument = atan2(leading(*zimag), leading(*zreal)) * (Scalar)DEGREE;
+
+    *zreal = toReal(modulus * cos(argument));
+    *zimag = toReal(modulus * sin(argument));
+#endif
+
+    *zreal = addReal(*zreal, creal);
+    *zimag = addReal(*zimag, cimag);
+}
+
+// adds amount to the cell that z lands in, and to its mirror image when mirrored, if z is inside of the band
+inline void bin(volatile global unsigned int *counts, const Real zreal, const Real zimag, const Real minReal, const Real minImag, const Real cellWidth, const unsigned int rows, const bool mirrored, const unsigned int amount) {
+    private Scalar row = floor(leading(subReal(zreal, minReal)) / leading(cellWidth));
+    private Scalar column = floor(leading(subReal(zimag, minImag)) / leading(cellWidth));
+
+    // compared before being converted, as converting a point far outside of the band to an int is undefined, and
+    // NaNs fail every comparison
+    if (row >= 0 && column >= 0 && row < (Scalar)rows && column < (Scalar)WIDTH) {
+        private int cellRow = (int)row;
+        private int cellColumn = (int)column;
+
+        atomic_add(&counts[cellRow * WIDTH + cellColumn], amount);
+
+        if (mirrored)
+            atomic_add(&counts[cellRow * WIDTH + (WIDTH - 1 - cellColumn)], amount);
+    }
+}
+
+#if VIEWS
+// row of a view's matrix applied to the point z of the orbit of c, i.e (Re z, Im z, Re c, Im c)
+inline Real project(global const Scalar *row, const Real zreal, const Real zimag, const Real creal, const Real cimag) {
+    return addReal(addReal(mulReal(toReal(row[0]), zreal), mulReal(toReal(row[1]), zimag)), addReal(mulReal(toReal(row[2]), creal), mulReal(toReal(row[3]), cimag)));
+}
+#endif
+
+// bins z into the band of the viewport and, when there are VIEWS projected views, into each of their bands after
+// it. projections holds the 2x4 matrix of every view, row by row
+inline void binAll(volatile global unsigned int *counts, const Real zreal, const Real zimag, const Real creal, const Real cimag, const Real minReal, const Real minImag, const Real cellWidth, const unsigned int rows, const bool mirrored, const unsigned int amount, global const Scalar *projections) {
+    bin(counts, zreal, zimag, minReal, minImag, cellWidth, rows, mirrored, amount);
+
+#if VIEWS
+    for (private unsigned int v = 0; v < VIEWS; ++v) {
+        global const Scalar *matrix = projections + v * 8;
+        volatile global unsigned int *view = counts + (v + 1) * rows * WIDTH;
+
+        // a view that keeps the real and imaginary parts apart sends the conjugate orbit to the mirror image, like
+        // the viewport does, otherwise the conjugate is projected for itself
+        private bool separable = matrix[1] == 0 && matrix[3] == 0 && matrix[4] == 0 && matrix[6] == 0;
+
+        bin(view, project(matrix, zreal, zimag, creal, cimag), project(matrix + 4, zreal, zimag, creal, cimag), minReal, minImag, cellWidth, rows, mirrored && separable, amount);
+
+        if (mirrored && !separable)
+            bin(view, project(matrix, zreal, -zimag, creal, -cimag), project(matrix + 4, zreal, -zimag, creal, -cimag), minReal, minImag, cellWidth, rows, false, amount);
+    }
+#endif
+}
+
+// runs the next iterationsCurrent iterations of every seed's orbit, continuing from where the previous group of
+// iterations left each orbit in currentCells. The check pass (CHECK) records which seeds contribute and how far
+// their orbits have been advanced, adding to what the previous groups left in counts, and the count pass bins every
+// point of the contributing orbits that lands inside of the WIDTH x rows band of the viewport starting from
+// minReal. The first mirrorCount seeds also bin their conjugate orbits, which requires the viewport to be centred on
+// the real axis. iterationsLeft counts this group's iterations and every group after it, so that an orbit found to
+// have settled into a cycle can bin all of its remaining repetitions at once. counts holds a band for the viewport
+// followed by one for each of the VIEWS projected views
+kernel void escape(global Real *seeds, global Real *currentCells, const Real minReal, const Real minImag, const Real cellWidth, const unsigned int iterationsCurrent, volatile global unsigned int *counts, const unsigned int cellsCurrent, const unsigned int mirrorCount, const unsigned int rows, const unsigned int iterationsLeft, global const Scalar *projections) {
+
+    private unsigned int count = get_global_id(0);
+
+    // cellsCurrent is an argument rather than a define so that built programs can be reused between renders
+    if (count < cellsCurrent) {
         private Real zreal = currentCells[count * 2 + 0],
             zimag = currentCells[count * 2 + 1];
 
-        private Real creal = originalCells[count * 2 + 0],
-            cimag = originalCells[count * 2 + 1];
+        private Real creal = seeds[count * 2 + 0],
+            cimag = seeds[count * 2 + 1];
 
-#endif
+        // Brent's cycle detection, comparing every point against the one saved at the last power of two iterations.
+        // It starts over every group, which only costs a couple of periods for an orbit already in its cycle
+        private Real savedReal = zreal,
+            savedImag = zimag;
+        private unsigned int power = 1,
+            period = 1;
 
-        private int oneLess = CELLS_PER_ROW - 1;
+#if CHECK
+        private unsigned int advanced = 0;
+#endif
 
         for (private unsigned int i = 0; i < iterationsCurrent; ++i) {
-            if (!isinf(zreal) && !isinf(zimag) && zreal != 0 && zimag != 0) {
-                // if a cell is invalid then it may be passed from the previous group and added updated by the advance section of the loop before the loop is broken. This means that the check for validity has to occur before the advancing of the complex number in order to have valid results and counts
-                private int visitedx = floor((zreal - minx) / cellRealWidth);
-                private int visitedy = floor((zimag - miny) / cellRealWidth);
+            // an orbit that escaped in a previous group is left where it escaped
+            if (norm(zreal, zimag) > (Scalar)BAILOUT_SQUARED)
+                break;
 
-                if (visitedx > oneLess || visitedy > oneLess || visitedx < 0 || visitedy < 0)
-                    break;
+            advance(&zreal, &zimag, creal, cimag);
+
+#if CHECK
+            ++advanced;
+#else
+            binAll(counts, zreal, zimag, creal, cimag, minReal, minImag, cellWidth, rows, count < mirrorCount, 1, projections);
+#endif
 
+#if CYCLES
+            if (norm(subReal(zreal, savedReal), subReal(zimag, savedImag)) < (Scalar)CYCLE_TOLERANCE_SQUARED) {
 #if !CHECK
-                atomic_inc(&counts[visitedx * CELLS_PER_ROW + visitedy]);
-#endif
-
-                // z = z^2 + c
-                private Real oldReal = zreal;
-                zreal = zreal * zreal - zimag * zimag;
-                zimag = 2 * oldReal * zimag;
-
-                zreal = zreal + creal;
-                zimag = zimag + cimag;
-                // advance ^^^^
-            } else if (i == 0 && zreal == 0 && zimag == 0) {
-                // only runs on first group of iterations
-                private Real oldReal = zreal;
-                zreal = zreal * zreal - zimag * zimag;
-                zimag = 2 * oldReal * zimag;
-
-                zreal = zreal + creal;
-                zimag = zimag + cimag;
-            } else
+                // every point still to come goes around the cycle of period points after z
+                private unsigned int remaining = iterationsLeft - (i + 1);
+
+                for (private unsigned int k = 0; k < period && k < remaining; ++k) {
+                    advance(&zreal, &zimag, creal, cimag);
+                    binAll(counts, zreal, zimag, creal, cimag, minReal, minImag, cellWidth, rows, count < mirrorCount, remaining / period + (k < remaining % period ? 1 : 0), projections);
+                }
+
+                // has nothing left to bin, so is parked past the bailout for the groups after this one
+                zreal = toReal((Scalar)BAILOUT_SQUARED + 1);
+                zimag = toReal(0);
+#endif
+                // a cycle never escapes, so the check pass' flag is already known
                 break;
-        }
+            }
 
-        private Real abs = hypot(zreal, zimag);
+            if (period == power) {
+                savedReal = zreal;
+                savedImag = zimag;
+                power *= 2;
+                period = 0;
+            }
 
-        interimResults[x * CELLS_PER_ROW * 2 + y * 2 + 0] = zreal;
-        interimResults[x * CELLS_PER_ROW * 2 + y * 2 + 1] = zimag;
+            ++period;
+#endif
+        }
+
+        currentCells[count * 2 + 0] = zreal;
+        currentCells[count * 2 + 1] = zimag;
 
 #if CHECK
-        if (ANTI ? abs < 2.0 : abs > 2.0) // regular buddhabrot means that the point escapes, thus > 2.0 for !anti
-            atomic_inc(&counts[x * CELLS_PER_ROW + y]);
+        private bool escaped = norm(zreal, zimag) > (Scalar)BAILOUT_SQUARED;
+
+        private unsigned int length = min((counts[count] & CHECK_LENGTH) + advanced, CHECK_LENGTH);
+
+        // regular buddhabrot means that the point escapes
+        counts[count] = ((ANTI ? !escaped : escaped) ? CHECK_CONTRIBUTES : 0) | length;
 #endif
     }
 }
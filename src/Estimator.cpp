@@ -0,0 +1,401 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Estimator.hpp"
+
+#include "Halton.hpp"
+#include "Orbit.hpp"
+#include "Topology.hpp"
+#include "Views.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <math.h>
+#include <string>
+#include <thread>
+
+static std::string megabytes(unsigned long long bytes) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.1fMB", bytes / 1048576.0);
+
+    return text;
+}
+
+std::vector<unsigned long int> Estimator::drawBlocks(const SeedGrid &grid) const {
+    const unsigned long int blockCount = (unsigned long int)grid.blockRows() * grid.blockColumns();
+
+    std::vector<unsigned long int> blocks;
+    std::vector<bool> drawn(blockCount, false);
+
+    unsigned long int evaluated = 0;
+    for (unsigned long int block = 0; block < blockCount; ++block)
+        evaluated += grid.blockEvaluated(block);
+
+    // the blocks are spread over the grid by the Halton sequence, covering it far more evenly than random blocks
+    // would, as neighbouring blocks are much alike. Blocks that are not evaluated or already drawn are skipped, so
+    // every evaluated block is eventually drawn
+    const Halton halton;
+
+    const unsigned long int share = (unsigned long int)ceil(evaluated * ESTIMATE_PILOT_FRACTION);
+    const unsigned long int target = std::min(evaluated, std::min<unsigned long int>(ESTIMATE_PILOT_BLOCKS, std::max<unsigned long int>(ESTIMATE_PILOT_MIN_BLOCKS, share)));
+
+    for (uint64_t index = 0; blocks.size() < target; ++index) {
+        long double x, y;
+        halton.point(index, &x, &y);
+
+        const unsigned long int block = (unsigned long int)(x * grid.blockRows()) * grid.blockColumns() + (unsigned long int)(y * grid.blockColumns());
+
+        if (!drawn[block] && grid.blockEvaluated(block)) {
+            drawn[block] = true;
+            blocks.push_back(block);
+        }
+    }
+
+    return blocks;
+}
+
+void Estimator::gatherPilot(const SeedGrid &grid, const std::vector<unsigned long int> &blocks) {
+    pilot.clear();
+    mirrored.clear();
+    classified.clear();
+    contributes.clear();
+
+    for (unsigned long int block : blocks) {
+        unsigned int firstRow, firstColumn, lastRow, lastColumn;
+        grid.blockBounds(block, &firstRow, &firstColumn, &lastRow, &lastColumn);
+
+        for (unsigned int row = firstRow; row <= lastRow; ++row) {
+            if (!grid.rowActive(row))
+                continue;
+
+            for (unsigned int column = firstColumn; column <= lastColumn; ++column) {
+                SeedKind kind = grid.kind(row, column);
+
+                if (kind == SEED_SKIPPED)
+                    continue;
+
+                pilot.push_back(grid.seed(row, column));
+                mirrored.push_back(kind == SEED_MIRRORED);
+                // seeds classified by the interior check are already known to contribute or not, and the rest are
+                // found out by evaluating them
+                SeedClass known = grid.classification(row, column);
+
+                classified.push_back(known != SEED_UNCLASSIFIED);
+                contributes.push_back(known != SEED_UNCLASSIFIED && (known == SEED_ESCAPES) != config.anti);
+            }
+        }
+    }
+}
+
+template <class Sink>
+void Estimator::evaluateSeeds(Sink *target, unsigned int threadId, unsigned int threadsTotal) {
+    const Power power(config.power, config.cycles);
+
+    std::vector<unsigned long int> visited;
+    ThreadCounters counters;
+
+    // as Renderer::escapeRows evaluates them
+    for (unsigned long int i = threadId; i < pilot.size(); i += threadsTotal) {
+        const unsigned long long before = counters.iterationsExecuted;
+
+        if (!classified[i])
+            contributes[i] = Orbit::escape(pilot[i], target, config.iterations, power, config.anti, mirrored[i] != 0, &visited, &counters);
+        else if (contributes[i])
+            Orbit::bin(pilot[i], target, config.iterations, power, mirrored[i] != 0, &counters);
+
+        iterations[i] = counters.iterationsExecuted - before;
+    }
+}
+
+void Estimator::evaluateThread(Histogram *histogram, std::vector<Histogram> *projected, unsigned int threadId, unsigned int threadsTotal) {
+    if (projected->empty()) {
+        evaluateSeeds(histogram, threadId, threadsTotal);
+        return;
+    }
+
+    Views views(histogram, projected, config.projections);
+    evaluateSeeds(&views, threadId, threadsTotal);
+}
+
+double Estimator::evaluatePilot(Histogram *histogram, std::vector<Histogram> *projected) {
+    iterations.assign(pilot.size(), 0);
+
+    const unsigned int numThreads = std::max(config.numThreads, 1u);
+
+    const double start = Statistics::now();
+
+    // interleaved rather than contiguous, as the pilot is in no particular order either way
+    std::vector<std::thread> threads;
+
+    for (unsigned int i = 0; i < numThreads - 1; ++i)
+        threads.push_back(std::thread(&Estimator::evaluateThread, this, histogram, projected, i, numThreads));
+
+    evaluateThread(histogram, projected, numThreads - 1, numThreads);
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    return Statistics::now() - start;
+}
+
+double Estimator::dispatchPilot(Histogram *histogram, std::vector<Histogram> *projected, double *setupSeconds) {
+    // the mirrored seeds first, as calculateSeeds expects them
+    std::vector<double> seeds;
+    cl_uint mirrorCount = 0;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (unsigned long int i = 0; i < pilot.size(); ++i) {
+            if (classified[i] || (mirrored[i] != 0) != (pass == 0))
+                continue;
+
+            seeds.push_back((double)pilot[i].real);
+            seeds.push_back((double)pilot[i].imag);
+        }
+
+        if (pass == 0)
+            mirrorCount = (cl_uint)(seeds.size() / 2);
+    }
+
+    Statistics deviceStats;
+
+    if (helper->calculateSeeds(histogram, projected, config, seeds, mirrorCount, &deviceStats) != 0)
+        return -1;
+
+    *setupSeconds = deviceStats.phase("setup") + deviceStats.phase("build");
+
+    return deviceStats.phase("check") + deviceStats.phase("count");
+}
+
+void Estimator::estimateMemory(const SeedGrid &grid, double checkedFraction, double knownFraction, Estimate *estimate) const {
+    const unsigned long long views = config.projections.size();
+    const unsigned long long histogramBytes = sizeof(unsigned int) * (unsigned long long)config.windowWidth * config.height();
+
+    // as in Histogram::allocate, each histogram goes to a file once it is over half of its share of the budget
+    const bool fileBacked = config.maxMemory != 0 && histogramBytes > config.maxMemory / (views + 1) / 2;
+
+    if (fileBacked)
+        estimate->diskBytes += histogramBytes * (views + 1);
+    else
+        estimate->hostBytes += histogramBytes * (views + 1);
+
+    // a byte per seed, of the interior check's classes and of the cache's states
+    if (config.interiorCheck())
+        estimate->hostBytes += grid.count();
+    if (!config.cacheDir.empty())
+        estimate->hostBytes += grid.count();
+
+    // a copy of the histogram per NUMA node, as Renderer::executeEscapes decides
+    if (!config.usesOpenCL() && config.pin && views == 0 && !fileBacked) {
+        Topology topology = Topology::detect();
+        const unsigned long long replicaBytes = histogramBytes * topology.nodeCount();
+
+        if (topology.canPin() && topology.nodeCount() > 1 && (config.maxMemory == 0 || replicaBytes <= config.maxMemory / 2))
+            estimate->hostBytes += replicaBytes;
+    }
+
+    if (!config.usesOpenCL())
+        return;
+
+    const KernelLayout &layout = estimate->layout;
+
+    const unsigned long long checked = (unsigned long long)(estimate->seeds * checkedFraction);
+    const unsigned long long known = (unsigned long long)(estimate->seeds * knownFraction);
+    const unsigned long long contributing = (unsigned long long)(estimate->seeds * estimate->contributingFraction);
+
+    // the seeds are gathered as pairs of doubles, then compacted into the contributing ones next to the check
+    // pass' flags and the order they are sorted into, and the count pass reads back a band of every view next to a
+    // chunk of seeds packed for the device
+    const unsigned long long compaction = 2 * sizeof(double) * (checked + known + contributing) + sizeof(cl_uint) * (checked + contributing);
+    const unsigned long long count = 2 * sizeof(double) * contributing + sizeof(cl_uint) * (unsigned long long)layout.bandRows * config.windowWidth * (views + 1) + 2ULL * layout.realBytes * layout.chunkSeeds;
+
+    estimate->hostBytes += std::max(compaction, count);
+    estimate->deviceBytes = layout.deviceBytes;
+}
+
+int Estimator::run(Estimate *estimate) {
+    *estimate = Estimate();
+
+    const bool cpu = !config.useGpu || config.hybrid;
+    const bool device = config.usesOpenCL();
+
+    // the pilot bins into the same viewport, at a lower resolution if the histogram is too large to be worth
+    // allocating, with as many views as the render
+    const unsigned long long histogramBytes = sizeof(unsigned int) * (unsigned long long)config.windowWidth * config.height() * (config.projections.size() + 1);
+    const long double scale = std::max(1.0L, sqrtl((long double)histogramBytes / ESTIMATE_PILOT_BYTES));
+
+    const unsigned int width = std::max(1u, (unsigned int)(config.windowWidth / scale));
+    const unsigned int height = std::max(1u, (unsigned int)(config.height() / scale));
+
+    Histogram histogram;
+    histogram.allocate(width, height, config.viewportMinReal(), config.viewportMinImag(), config.cellWidth() * config.windowWidth / width);
+
+    std::vector<Histogram> projected(config.projections.size());
+    for (Histogram &view : projected)
+        view.allocate(width, height, histogram.minReal, histogram.minImag, histogram.cellWidth);
+
+    // culling decides which seeds there are to estimate, and is cheap enough to just run
+    SeedGrid grid(config);
+
+    if (grid.cullable(&histogram, config)) {
+        const double cullStart = Statistics::now();
+
+        grid.cull(&histogram, config);
+
+        estimate->cullSeconds = Statistics::now() - cullStart;
+    }
+
+    estimate->seeds = grid.evaluatedCount();
+
+    const std::vector<unsigned long int> blocks = drawBlocks(grid);
+
+    unsigned long int evaluatedBlocks = 0;
+    for (unsigned long int block = 0; block < (unsigned long int)grid.blockRows() * grid.blockColumns(); ++block)
+        evaluatedBlocks += grid.blockEvaluated(block);
+
+    if (config.interiorCheck()) {
+        const double interiorStart = Statistics::now();
+
+        unsigned long int iterated;
+        grid.classifyBlocks(config, blocks, &iterated);
+
+        estimate->interiorSeconds = (Statistics::now() - interiorStart) * evaluatedBlocks / std::max<double>(blocks.size(), 1);
+    }
+
+    gatherPilot(grid, blocks);
+    estimate->pilotSeeds = pilot.size();
+
+    // small grids need more than their share of blocks for a pilot to go by, up to the whole grid, which is then
+    // simply measured rather than extrapolated from
+    if (blocks.size() == evaluatedBlocks)
+        std::cout << "Evaluating every one of the " << estimate->seeds << " seeds, as the render is too small for a pilot" << std::endl;
+    else if (blocks.size() > ceil(evaluatedBlocks * ESTIMATE_PILOT_FRACTION))
+        std::cout << "Evaluating a pilot of " << pilot.size() << '/' << estimate->seeds << " seeds, more than usual as the render is small" << std::endl;
+    else
+        std::cout << "Evaluating a pilot of " << pilot.size() << '/' << estimate->seeds << " seeds" << std::endl;
+
+    const double cpuSeconds = evaluatePilot(&histogram, &projected);
+
+    // the device iterates every seed it has to check in the check pass, and every contributing one, checked or
+    // classified, again in the count pass. The pilot's own dispatch only checks the seeds that were not classified
+    double iterated = 0, contributingIterations = 0, checkedIterations = 0, checkedContributingIterations = 0;
+    unsigned long int orbits = 0, contributing = 0, checked = 0, known = 0;
+
+    for (unsigned long int i = 0; i < pilot.size(); ++i) {
+        if (iterations[i] != 0) {
+            orbits++;
+            iterated += iterations[i];
+        }
+
+        if (contributes[i]) {
+            contributing++;
+            contributingIterations += iterations[i];
+        }
+
+        if (!classified[i]) {
+            checked++;
+            checkedIterations += iterations[i];
+
+            if (contributes[i])
+                checkedContributingIterations += iterations[i];
+        } else if (contributes[i])
+            known++;
+    }
+
+    const double pilotCount = std::max<double>(pilot.size(), 1);
+    const double seedScale = estimate->seeds / pilotCount;
+
+    estimate->contributingFraction = contributing / pilotCount;
+    estimate->classifiedFraction = (pilot.size() - checked) / pilotCount;
+    estimate->meanIterations = orbits != 0 ? iterated / orbits : 0;
+    estimate->meanContributingIterations = contributing != 0 ? contributingIterations / contributing : 0;
+
+    // the CPU did just what the render would, for a share of its seeds
+    double cpuRenderSeconds = 0;
+
+    if (cpu) {
+        estimate->cpuSecondsPerOrbit = cpuSeconds / pilotCount;
+        cpuRenderSeconds = cpuSeconds * seedScale;
+    }
+
+    double deviceRenderSeconds = 0;
+
+    if (device) {
+        const double deviceSeconds = checked == 0 ? 0 : dispatchPilot(&histogram, &projected, &estimate->setupSeconds);
+        if (deviceSeconds < 0)
+            return 1;
+
+        if (helper->layout(config, config.windowWidth, config.height(), (unsigned long int)(checked * seedScale), estimate->seeds, &estimate->layout) != 0)
+            return 1;
+
+        const double pilotWork = checkedIterations + checkedContributingIterations;
+        const double secondsPerIteration = pilotWork > 0 ? deviceSeconds / pilotWork : 0;
+
+        estimate->deviceSecondsPerOrbit = deviceSeconds / pilotCount;
+        deviceRenderSeconds = secondsPerIteration * (checkedIterations + contributingIterations) * seedScale;
+
+        // a launch runs every seed of a chunk for up to a group of iterations, the first group of the check pass
+        // being the longest as none of its orbits have escaped yet
+        double checkGroup = 0, countGroup = 0;
+
+        for (unsigned long int i = 0; i < pilot.size(); ++i) {
+            const double group = std::min<double>(iterations[i], estimate->layout.iterationsMax);
+
+            if (!classified[i])
+                checkGroup += group;
+            if (contributes[i])
+                countGroup += group;
+        }
+
+        const double chunk = estimate->layout.chunkSeeds;
+
+        checkGroup = checked != 0 ? checkGroup / checked * std::min(chunk, checked * seedScale) : 0;
+        countGroup = contributing != 0 ? countGroup / contributing * std::min(chunk, contributing * seedScale) : 0;
+
+        estimate->launchSeconds = secondsPerIteration * std::max(checkGroup, countGroup);
+    }
+
+    // in a hybrid render, the CPU and the device work through the seeds at once, each at its own rate
+    double calculationSeconds = cpu ? cpuRenderSeconds : deviceRenderSeconds;
+    if (cpu && device && cpuRenderSeconds > 0 && deviceRenderSeconds > 0)
+        calculationSeconds = 1 / (1 / cpuRenderSeconds + 1 / deviceRenderSeconds);
+
+    estimate->seconds = estimate->cullSeconds + estimate->interiorSeconds + estimate->setupSeconds + calculationSeconds;
+
+    estimateMemory(grid, checked / pilotCount, known / pilotCount, estimate);
+
+    return 0;
+}
+
+void printEstimate(const Estimate &estimate, const RenderConfig &config) {
+    const bool cpu = !config.useGpu || config.hybrid;
+    const bool device = config.usesOpenCL();
+
+    std::cout << std::endl << "Estimated render :" << std::endl;
+    printf("\tseeds evaluated\t\t %lu\n", estimate.seeds);
+    printf("\tpilot seeds\t\t %lu\n", estimate.pilotSeeds);
+    printf("\tcontributing seeds\t %.3g%%\n", estimate.contributingFraction * 100);
+    printf("\tclassified seeds\t %.3g%%\n", estimate.classifiedFraction * 100);
+    printf("\tmean orbit\t\t %.1f iterations\n", estimate.meanIterations);
+    printf("\tmean contributing orbit\t %.1f iterations\n", estimate.meanContributingIterations);
+    printf(cpu ? "\tCPU time per orbit\t %.3gus\n" : "\tCPU time per orbit\t N/A\n", estimate.cpuSecondsPerOrbit * 1E6);
+    printf(device ? "\tOpenCL time per orbit\t %.3gus\n" : "\tOpenCL time per orbit\t N/A\n", estimate.deviceSecondsPerOrbit * 1E6);
+    printf("\titerations per group\t %s\n", device ? std::to_string(estimate.layout.iterationsMax).c_str() : "N/A");
+    printf("\tseeds per launch\t %s\n", device ? std::to_string(estimate.layout.chunkSeeds).c_str() : "N/A");
+    printf(device ? "\tlongest launch\t\t %.3gs\n" : "\tlongest launch\t\t N/A\n", estimate.launchSeconds);
+    printf("\tculling\t\t\t %.3gs\n", estimate.cullSeconds);
+    printf("\tinterior check\t\t %.3gs\n", estimate.interiorSeconds);
+    printf(device ? "\tOpenCL setup\t\t %.3gs\n" : "\tOpenCL setup\t\t N/A\n", estimate.setupSeconds);
+    printf("\ttotal\t\t\t %.3gs\n", estimate.seconds);
+    printf("\thost memory\t\t %s\n", megabytes(estimate.hostBytes).c_str());
+    printf("\tdisk memory\t\t %s\n", megabytes(estimate.diskBytes).c_str());
+    printf("\tdevice memory\t\t %s\n", device ? megabytes(estimate.deviceBytes).c_str() : "N/A");
+
+    std::cout << std::endl;
+}
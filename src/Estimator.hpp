@@ -0,0 +1,107 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "ComplexNumber.hpp"
+#include "Histogram.hpp"
+#include "OpenCLKernelHelper.hpp"
+#include "RenderConfig.hpp"
+#include "SeedGrid.hpp"
+#include "Statistics.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#ifndef Estimator_hpp
+#define Estimator_hpp
+
+// share of the evaluated blocks of the interior pre-pass, of INTERIOR_BLOCK_SIZE seeds per side, spread over the
+// grid to size up a render, between a minimum that keeps small grids from being estimated from a handful of blocks
+// and a maximum that keeps large ones cheap
+static const double ESTIMATE_PILOT_FRACTION = 0.04;
+static const unsigned int ESTIMATE_PILOT_MIN_BLOCKS = 16;
+static const unsigned int ESTIMATE_PILOT_BLOCKS = 256;
+
+// largest histogram that the pilot bins into. Binning into anything much larger than the caches is limited by
+// memory, so costs about the same per increment whatever the size
+static const unsigned long long ESTIMATE_PILOT_BYTES = 256ULL << 20;
+
+// what a render would cost, predicted from the pilot
+struct Estimate {
+    unsigned long int seeds;      // evaluated by the render, after culling, symmetry and sharding
+    unsigned long int pilotSeeds;
+
+    double contributingFraction;  // of the seeds, binned into the histogram
+    double classifiedFraction;    // of the seeds, classified by the interior check
+    double meanIterations;        // of every orbit that is iterated
+    double meanContributingIterations;
+
+    double cpuSecondsPerOrbit;    // over every thread, 0 when the CPU is not used
+    double deviceSecondsPerOrbit; // over the check and count passes, 0 when OpenCL is not used
+
+    double cullSeconds;           // ran for real, as the seeds it drops are needed
+    double interiorSeconds;
+    double setupSeconds;          // OpenCL context and kernel builds
+    double seconds;               // wall time of the whole calculation
+
+    KernelLayout layout;          // of the OpenCL passes, when used
+    double launchSeconds;         // longest single kernel launch, which has to stay short enough not to hang the device
+
+    unsigned long long hostBytes;
+    unsigned long long diskBytes;   // of file-backed histograms
+    unsigned long long deviceBytes;
+
+    Estimate() : seeds(0), pilotSeeds(0), contributingFraction(0), classifiedFraction(0), meanIterations(0), meanContributingIterations(0), cpuSecondsPerOrbit(0), deviceSecondsPerOrbit(0), cullSeconds(0), interiorSeconds(0), setupSeconds(0), seconds(0), layout(), launchSeconds(0), hostBytes(0), diskBytes(0), deviceBytes(0) {};
+};
+
+// predicts the runtime and peak memory of a render from a pilot of blocks of seeds spread over the grid. The pilot goes
+// through the interior check and the render's own backend just as the whole grid would, binning into a small
+// histogram of the same viewport, and its times are scaled up by how many more seeds and blocks the render has.
+// Blocks rather than single seeds, so that the interior check sees the same rectangles as it would in the render.
+// The seed cache is left out, predicting a render that starts from nothing
+class Estimator {
+private:
+    RenderConfig config;
+    OpenCLKernelHelper *helper;
+
+    // per seed of the pilot, as found by the CPU
+    std::vector<ComplexNumber> pilot;
+    std::vector<char> mirrored;
+    std::vector<char> classified;
+    std::vector<char> contributes;
+    std::vector<uint64_t> iterations; // 0 for seeds classified as not contributing
+
+    // ESTIMATE_PILOT_FRACTION of the evaluated blocks, within ESTIMATE_PILOT_MIN_BLOCKS and ESTIMATE_PILOT_BLOCKS
+    // and never more than every one of them, spread by a Halton sequence, the same every time
+    std::vector<unsigned long int> drawBlocks(const SeedGrid &grid) const;
+    void gatherPilot(const SeedGrid &grid, const std::vector<unsigned long int> &blocks);
+
+    // evaluates the pilot over every thread, returning the wall time
+    double evaluatePilot(Histogram *histogram, std::vector<Histogram> *projected);
+    void evaluateThread(Histogram *histogram, std::vector<Histogram> *projected, unsigned int threadId, unsigned int threadsTotal);
+
+    template <class Sink>
+    void evaluateSeeds(Sink *target, unsigned int threadId, unsigned int threadsTotal);
+
+    // the pilot's check and count passes on the device over the seeds it has to check, returning their time or a
+    // negative number on failure
+    double dispatchPilot(Histogram *histogram, std::vector<Histogram> *projected, double *setupSeconds);
+
+    // the fractions are of the seeds going through the check pass, and of those known to contribute without it
+    void estimateMemory(const SeedGrid &grid, double checkedFraction, double knownFraction, Estimate *estimate) const;
+
+public:
+    // without a helper, OpenCL renders go through the shared helper of config.device
+    Estimator(const RenderConfig &config, OpenCLKernelHelper *helper = NULL) : config(config), helper(helper ? helper : OpenCLKernelHelper::shared(config.device)) {};
+
+    int run(Estimate *estimate);
+};
+
+void printEstimate(const Estimate &estimate, const RenderConfig &config);
+
+#endif // Estimator_hpp
@@ -0,0 +1,47 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Halton.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+
+Halton::Halton(uint64_t scramble) {
+    std::mt19937_64 generator(scramble);
+
+    shift2 = generator();
+
+    for (unsigned int k = 0; k < HALTON_BASE3_DIGITS; ++k)
+        shifts3[k] = (unsigned char)(generator() % 3);
+}
+
+void Halton::point(uint64_t index, long double *x, long double *y) const {
+    // base 2 reverses the bits of the index, so its digits can all be shifted in one go
+    uint64_t reversed = 0;
+    for (uint64_t bits = index, k = 0; k < 64; ++k, bits >>= 1)
+        reversed = (reversed << 1) | (bits & 1);
+
+    *x = ldexpl((long double)(reversed ^ shift2), -64);
+
+    // every digit is shifted, the zeros past the index's last digit included, so the points do not all sit on
+    // the grid of the first few digits
+    long double value = 0;
+    long double scale = 1.0L / 3;
+
+    for (unsigned int k = 0; k < HALTON_BASE3_DIGITS; ++k) {
+        value += ((index % 3 + shifts3[k]) % 3) * scale;
+
+        index /= 3;
+        scale /= 3;
+    }
+
+    // the largest values round up to 1 in a long double
+    *y = std::min(value, nextafterl(1, 0));
+}
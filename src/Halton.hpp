@@ -0,0 +1,35 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include <cstdint>
+
+#ifndef Halton_hpp
+#define Halton_hpp
+
+// digits of the base 3 radical inverse, enough to resolve as finely as the 64 bits of the base 2 one
+static const unsigned int HALTON_BASE3_DIGITS = 41;
+
+// the 2D Halton sequence, the radical inverses of the index in bases 2 and 3, scrambled by shifting every digit by
+// a fixed random amount. The shifts keep the sequence's low discrepancy, its points covering the square far more
+// evenly than random ones, while breaking up the lattice that the first points of the plain sequence line up in.
+// Any point is worked out from its index alone, so workers can each take their own range of indices
+class Halton {
+private:
+    uint64_t shift2; // xor of the base 2 digits, i.e a random shift of each one
+    unsigned char shifts3[HALTON_BASE3_DIGITS];
+
+public:
+    // scramble picks the shifts, every render with the same scramble drawing the same points
+    Halton(uint64_t scramble = 0);
+
+    // the index-th point, in [0, 1) x [0, 1)
+    void point(uint64_t index, long double *x, long double *y) const;
+};
+
+#endif // Halton_hpp
@@ -0,0 +1,144 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Histogram.hpp"
+
+#ifndef _WIN32
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static_assert(sizeof(std::atomic<unsigned int>) == sizeof(unsigned int), "histogram counts are mapped straight from a file");
+
+// maps a zero-filled temporary file of length bytes, which is unlinked straight away so it disappears with the process
+static void *mapTemporaryFile(unsigned long int length) {
+#ifdef _WIN32
+    (void)length;
+    return NULL;
+#else
+    const char *directory = getenv("TMPDIR");
+    std::string path = std::string(directory ? directory : "/tmp") + "/buddhabrot-histogram-XXXXXX";
+
+    std::vector<char> pathBuffer(path.begin(), path.end());
+    pathBuffer.push_back('\0');
+
+    int fd = mkstemp(pathBuffer.data());
+    if (fd < 0)
+        return NULL;
+
+    unlink(pathBuffer.data());
+
+    void *mapping = NULL;
+    if (ftruncate(fd, length) == 0) {
+        mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED)
+            mapping = NULL;
+    }
+
+    close(fd);
+
+    return mapping;
+#endif
+}
+
+Histogram::~Histogram() {
+    release();
+}
+
+void Histogram::allocate(unsigned int width, unsigned int height, long double minReal, long double minImag, long double cellWidth, unsigned long long maxMemory) {
+    release();
+
+    this->width = width;
+    this->height = height;
+    this->minReal = minReal;
+    this->minImag = minImag;
+    this->cellWidth = cellWidth;
+    inverseCellWidth = 1.0 / cellWidth;
+
+    const unsigned long int bytes = sizeof(unsigned int) * size();
+    const unsigned long int rowBytes = sizeof(unsigned int) * std::max(width, 1u);
+
+    // a tile takes up to a quarter of the budget, leaving room for the writers' and the GPU's own buffers
+    tileRows = maxMemory == 0 ? height : (unsigned int)std::max(1ULL, std::min((unsigned long long)height, maxMemory / 4 / rowBytes));
+    tileRows = std::max(tileRows, 1u);
+
+    if (maxMemory != 0 && bytes > maxMemory / 2) {
+        void *mapping = mapTemporaryFile(bytes);
+
+        if (mapping) {
+            counts = (std::atomic<unsigned int>*)mapping;
+            mappedBytes = bytes;
+
+            std::cout << "Histogram of " << (bytes >> 20) << "MB is backed by a temporary file, in tiles of " << tileRows << " rows" << std::endl;
+            return;
+        }
+
+        std::cout << "Failed to map a temporary file for the histogram, keeping it in memory" << std::endl;
+    }
+
+    counts = new std::atomic<unsigned int>[size()];
+
+    for (unsigned long int i = 0; i < size(); ++i)
+        counts[i].store(0, std::memory_order_relaxed);
+}
+
+void Histogram::release() {
+#ifndef _WIN32
+    if (mappedBytes != 0) {
+        munmap((void*)counts, mappedBytes);
+
+        counts = NULL;
+        mappedBytes = 0;
+    }
+#endif
+
+    delete[] counts;
+    counts = NULL;
+}
+
+void Histogram::flushRows(unsigned int firstRow, unsigned int rows) const {
+#ifndef _WIN32
+    if (mappedBytes == 0 || rows == 0)
+        return;
+
+    // madvise needs page aligned addresses, so only whole pages inside of the rows are dropped
+    const unsigned long int pageSize = sysconf(_SC_PAGESIZE);
+
+    unsigned long int start = (unsigned long int)(counts + (unsigned long int)firstRow * width);
+    unsigned long int end = (unsigned long int)(counts + (unsigned long int)(firstRow + rows) * width);
+
+    start = (start + pageSize - 1) / pageSize * pageSize;
+    end = end / pageSize * pageSize;
+
+    if (start < end) {
+        msync((void*)start, end - start, MS_ASYNC);
+        madvise((void*)start, end - start, MADV_DONTNEED);
+    }
+#else
+    (void)firstRow;
+    (void)rows;
+#endif
+}
+
+unsigned int Histogram::maxCount() const {
+    unsigned int result = 0;
+
+    for (unsigned long int i = 0; i < size(); ++i) {
+        unsigned int count = get(i);
+        if (count > result)
+            result = count;
+    }
+
+    return result;
+}
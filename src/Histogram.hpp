@@ -0,0 +1,99 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+
+#ifndef Histogram_hpp
+#define Histogram_hpp
+
+// counts of how many orbit points landed in each pixel of the viewport. Rows run along the real axis and
+// columns along the imaginary axis, so that the buddhabrot renders "sitting-down". Increments are atomic so
+// every worker thread can share one histogram.
+//
+// The rows are split into tiles, bands of whole rows, that the OpenCL path and writers work through one at a
+// time. When the histogram is larger than the memory budget, it is backed by a memory-mapped temporary file
+// instead of the heap, so only the tiles in use have to be resident
+class Histogram {
+private:
+    std::atomic<unsigned int> *counts;
+    unsigned long int mappedBytes; // length of the mapping when file-backed, otherwise 0
+
+public:
+    unsigned int width;  // columns, along the imaginary axis
+    unsigned int height; // rows, along the real axis
+    unsigned int tileRows;
+
+    long double minReal;
+    long double minImag;
+    long double cellWidth;
+    long double inverseCellWidth;
+
+    Histogram() : counts(NULL), mappedBytes(0), width(0), height(0), tileRows(0), minReal(0), minImag(0), cellWidth(0), inverseCellWidth(0) {};
+    ~Histogram();
+
+    Histogram(const Histogram&) = delete;
+    Histogram &operator=(const Histogram&) = delete;
+
+    // maxMemory of 0 keeps the whole histogram on the heap as a single tile
+    void allocate(unsigned int width, unsigned int height, long double minReal, long double minImag, long double cellWidth, unsigned long long maxMemory = 0);
+    void release();
+
+    bool allocated() const { return counts != NULL; };
+    bool fileBacked() const { return mappedBytes != 0; };
+    unsigned long int size() const { return (unsigned long int)width * height; };
+
+    unsigned int tileCount() const { return tileRows == 0 ? 0 : (height + tileRows - 1) / tileRows; };
+    unsigned int tileFirstRow(unsigned int tile) const { return tile * tileRows; };
+    unsigned int tileRowCount(unsigned int tile) const { return std::min(tileRows, height - tile * tileRows); };
+
+    // done with a range of rows for now, letting a file-backed histogram write them out and drop them from memory
+    void flushRows(unsigned int firstRow, unsigned int rows) const;
+
+    // finds the pixel that a point lands in, returning false if it is outside of the viewport
+    inline bool index(long double real, long double imag, unsigned long int *index) const {
+        long double row = floor((real - minReal) * inverseCellWidth);
+        long double column = floor((imag - minImag) * inverseCellWidth);
+
+        if (row < 0 || column < 0 || row >= height || column >= width)
+            return false;
+
+        *index = (unsigned long int)row * width + (unsigned long int)column;
+        return true;
+    };
+
+    // as above, also finding the pixel of the point's conjugate. Only meaningful for a viewport centred on the real axis
+    inline bool index(long double real, long double imag, unsigned long int *index, unsigned long int *mirrored) const {
+        long double row = floor((real - minReal) * inverseCellWidth);
+        long double column = floor((imag - minImag) * inverseCellWidth);
+
+        if (row < 0 || column < 0 || row >= height || column >= width)
+            return false;
+
+        *index = (unsigned long int)row * width + (unsigned long int)column;
+        *mirrored = (unsigned long int)row * width + (width - 1 - (unsigned long int)column);
+        return true;
+    };
+
+    inline void increment(unsigned long int index) { counts[index].fetch_add(1, std::memory_order_relaxed); };
+    inline void add(unsigned long int index, unsigned int amount) { counts[index].fetch_add(amount, std::memory_order_relaxed); };
+
+    inline unsigned int get(unsigned long int index) const { return counts[index].load(std::memory_order_relaxed); };
+    inline unsigned int get(unsigned int row, unsigned int column) const { return get((unsigned long int)row * width + column); };
+    inline void set(unsigned long int index, unsigned int value) { counts[index].store(value, std::memory_order_relaxed); };
+
+    // lower corner of a pixel in the complex plane
+    long double pixelReal(unsigned int row) const { return minReal + cellWidth * row; };
+    long double pixelImag(unsigned int column) const { return minImag + cellWidth * column; };
+
+    unsigned int maxCount() const;
+};
+
+#endif // Histogram_hpp
@@ -1,6 +1,6 @@
 //===========================================================================//
 ///
-/// Copyright Jim Carty © 2020
+/// Copyright Jim Carty © 2020-2021
 ///
 /// This file is subject to the terms and conditions defined in file
 /// 'LICENSE.txt', which is part of this source code package.
@@ -9,236 +9,732 @@
 
 #include "OpenCLKernelHelper.hpp"
 
+#include "Orbit.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <math.h>
+#include <sstream>
 
-static Real** g_cellsGPU;
-static unsigned int* g_maxCount;
-static std::pair<Real, Real> MIN_GPU;
-static Real cellRealWidth;
-static unsigned long int count;
-static unsigned long int inputCount;
-static unsigned int cellsPerRow;
+OpenCLKernelHelper::~OpenCLKernelHelper() {
+    for (std::pair<const std::string, cl_program> &p : programs)
+        clReleaseProgram(p.second);
 
-void calculateCells(Real** cellsGPU, unsigned int* maxCount, unsigned int* iterations, unsigned int* cellsPerRowPassed, const std::pair<long double, long double>* min, long double* cellRealWidthPassed, bool* anti, unsigned int* iterationsMax) {
-    printf("Using %d-bit (%s) floating point precision\n", PRECISION, PRECISION == 64 ? "double" : "float");
+    for (cl_command_queue commands : idleQueues)
+        clReleaseCommandQueue(commands);
 
-    g_cellsGPU = cellsGPU;
-    g_maxCount = maxCount;
-    cellsPerRow = *cellsPerRowPassed;
+    if (context)
+        clReleaseContext(context);
+    if (deviceId)
+        clReleaseDevice(deviceId);
+}
 
-    count = (unsigned long int) cellsPerRow * cellsPerRow;
-    inputCount = count * 2;
+OpenCLKernelHelper *OpenCLKernelHelper::shared(int device) {
+    static std::mutex sharedMutex;
+    static std::map<int, OpenCLKernelHelper*> helpers;
 
-    if (*iterationsMax == 0) {
-        *iterationsMax = (unsigned int)(3.28E11 * pow(cellsPerRow, -2.06));
+    std::lock_guard<std::mutex> lock(sharedMutex);
 
-        if (*anti)
-            *iterationsMax = (unsigned int) ceil(*iterationsMax / 8);
-    }
+    // never freed, as renders may still be running through them when the process exits
+    OpenCLKernelHelper *&helper = helpers[device];
+    if (!helper)
+        helper = new OpenCLKernelHelper(device);
 
-    std::cout << "Iterations per group := " << *iterationsMax << std::endl;
+    return helper;
+}
 
-    // 1000-500 maximum for 6001
-    // ~5500 maximum for 2001
-    // >7500 maximum for 501
+// every device of every platform, in the order that --device counts them
+static std::vector<std::pair<cl_platform_id, cl_device_id>> allDevices() {
+    std::vector<std::pair<cl_platform_id, cl_device_id>> found;
 
-    cl_platform_id platformId;
-    cl_device_id deviceId;
-    cl_context context;
-    cl_command_queue commands;
-    cl_kernel kernelCheck;
-    cl_kernel kernelCount;
-    cl_program program;
+    cl_uint numPlatforms = 0;
+    if (clGetPlatformIDs(0, NULL, &numPlatforms) != CL_SUCCESS || numPlatforms == 0)
+        return found;
 
-    cl_int err;
+    std::vector<cl_platform_id> platforms(numPlatforms);
+    if (clGetPlatformIDs(numPlatforms, platforms.data(), NULL) != CL_SUCCESS)
+        return found;
 
-    (*g_cellsGPU) = new Real[count * 3];
-    Real* originalCells = new Real[inputCount];
-    Real* interimResultsCheck = new Real[inputCount]();
+    for (cl_platform_id platform : platforms) {
+        cl_uint numDevices = 0;
+        if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 0, NULL, &numDevices) != CL_SUCCESS || numDevices == 0)
+            continue;
 
-    cellRealWidth = (Real)*cellRealWidthPassed;
-    MIN_GPU = { (Real)min->first, (Real)min->second };
+        std::vector<cl_device_id> devices(numDevices);
+        if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, numDevices, devices.data(), NULL) != CL_SUCCESS)
+            continue;
 
-    for (unsigned int i = 0; i < cellsPerRow; ++i) {
-        for (unsigned int j = 0; j < cellsPerRow; ++j) {
-            Real realx = MIN_GPU.first + cellRealWidth * (cellsPerRow - 1 - i); // inverting iteration through cells on the x-axis so that the buddhabrot renders "sitting-down" -- more picturesque
-            Real realy = MIN_GPU.second + cellRealWidth * j;
+        for (cl_device_id device : devices)
+            found.push_back(std::make_pair(platform, device));
+    }
 
-            (*g_cellsGPU)[i * cellsPerRow * 3 + j * 3 + 0] = realx;
-            (*g_cellsGPU)[i * cellsPerRow * 3 + j * 3 + 1] = realy;
-            (*g_cellsGPU)[i * cellsPerRow * 3 + j * 3 + 2] = 0;
+    return found;
+}
 
-            originalCells[i * cellsPerRow * 2 + j * 2 + 0] = realx;
-            originalCells[i * cellsPerRow * 2 + j * 2 + 1] = realy;
-        }
+static std::string deviceString(cl_device_id device, cl_device_info param) {
+    size_t length = 0;
+    if (clGetDeviceInfo(device, param, 0, NULL, &length) != CL_SUCCESS || length == 0)
+        return "";
+
+    std::vector<char> text(length);
+    if (clGetDeviceInfo(device, param, length, text.data(), NULL) != CL_SUCCESS)
+        return "";
+
+    return std::string(text.data());
+}
+
+static cl_device_type deviceType(cl_device_id device) {
+    cl_device_type type = 0;
+    clGetDeviceInfo(device, CL_DEVICE_TYPE, sizeof(type), &type, NULL);
+
+    return type;
+}
+
+std::vector<std::string> OpenCLKernelHelper::devices() {
+    std::vector<std::string> names;
+
+    for (const std::pair<cl_platform_id, cl_device_id> &found : allDevices()) {
+        const cl_device_type type = deviceType(found.second);
+        names.push_back(deviceString(found.second, CL_DEVICE_NAME) + (type & CL_DEVICE_TYPE_GPU ? " (GPU)" : type & CL_DEVICE_TYPE_CPU ? " (CPU)" : ""));
     }
 
-    cl_uint numPlatforms;
-    err = clGetPlatformIDs(1, &platformId, &numPlatforms);
-    if (err != CL_SUCCESS) {
+    return names;
+}
+
+int OpenCLKernelHelper::initialise() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (initialised)
+        return initialiseResult;
+
+    initialised = true;
+    initialiseResult = 1;
+
+    cl_int err;
+
+    std::vector<std::pair<cl_platform_id, cl_device_id>> found = allDevices();
+    if (found.empty()) {
         std::cout << "Failed to find an OpenCL platform. Check OpenCL install or use without -o option" << std::endl;
-        exit(1);
+        return 1;
     }
 
-    err = clGetDeviceIDs(platformId, CL_DEVICE_TYPE_GPU, 1, &deviceId, NULL);
-    if (err != CL_SUCCESS) {
-        std::cout << "GPU device not found. Check install or use without -o option" << std::endl;
-        exit(1);
+    if (deviceIndex >= 0) {
+        if (deviceIndex >= (int)found.size()) {
+            std::cout << "OpenCL device " << deviceIndex << " not found, there are " << found.size() << ". Check --device or use without -o option" << std::endl;
+            return 1;
+        }
+
+        platformId = found[deviceIndex].first;
+        deviceId = found[deviceIndex].second;
+    } else {
+        for (const std::pair<cl_platform_id, cl_device_id> &candidate : found) {
+            if (deviceType(candidate.second) & CL_DEVICE_TYPE_GPU) {
+                platformId = candidate.first;
+                deviceId = candidate.second;
+                break;
+            }
+        }
+
+        if (!deviceId) {
+            std::cout << "GPU device not found. Check install, pick another device with --device or use without -o option" << std::endl;
+            return 1;
+        }
     }
 
+    deviceName = deviceString(deviceId, CL_DEVICE_NAME);
+
+    // the extensions are a space separated list, so each name is looked for with the spaces around it
+    const std::string extensions = " " + deviceString(deviceId, CL_DEVICE_EXTENSIONS) + " ";
+    doubleSupported = extensions.find(" cl_khr_fp64 ") != std::string::npos || extensions.find(" cl_amd_fp64 ") != std::string::npos;
+
     context = clCreateContext(0, 1, &deviceId, NULL, NULL, &err);
     if (!context) {
         std::cout << "Couldn't create a compute context using GPU. Check OpenCL install or use without -o option" << std::endl;
-        exit(1);
+        return 1;
     }
 
-    commands = clCreateCommandQueue(context, deviceId, 0, &err);
-    if (!commands) {
-        std::cout << "Failed to create a command queue. Check OpenCL install or use without -o option" << std::endl;
-        exit(1);
-    }
+    err = clGetDeviceInfo(deviceId, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(maxAllocation), &maxAllocation, NULL);
+    if (err != CL_SUCCESS || maxAllocation == 0)
+        maxAllocation = 128ULL << 20; // the least that OpenCL guarantees
 
     size_t length = 0;
-    char* source;
-    err = loadTextFromFile(KERNEL_FILENAME, &source, &length);
+    char* text;
+    err = loadTextFromFile(KERNEL_FILENAME, &text, &length);
     if (err != 0) {
         std::cout << "Failed to load kernel source. Check where program is executed from, must be able to see src/, which contains EscapeKernel.cl" << std::endl;
-        exit(1);
+        return 1;
     }
 
-    program = clCreateProgramWithSource(context, 1, (const char**)&source, NULL, &err);
-    if (!program || err != CL_SUCCESS) {
-        std::cout << "Failed to create program from source. Check OpenCL install or use without -o option" << std::endl;
-        exit(1);
+    source = std::string(text, length);
+    free(text);
+
+    initialiseResult = 0;
+    return 0;
+}
+
+KernelPrecision OpenCLKernelHelper::resolvePrecision(KernelPrecision requested) {
+    // without a device, the render fails before the precision matters
+    if (initialise() != 0)
+        return requested == PRECISION_AUTO ? PRECISION_FLOAT : requested;
+
+    if (requested == PRECISION_AUTO)
+        return doubleSupported ? PRECISION_DOUBLE : PRECISION_FLOAT_FLOAT;
+
+    if (requested == PRECISION_DOUBLE && !doubleSupported)
+        return PRECISION_FLOAT_FLOAT;
+
+    return requested;
+}
+
+unsigned int OpenCLKernelHelper::precisionBits(KernelPrecision precision) {
+    switch (precision) {
+        case PRECISION_DOUBLE: return 64;
+        case PRECISION_FLOAT_FLOAT: return 48;
+        default: return 32;
     }
-    free(source);
+}
 
-    // Build the program executable for running check kernel
-    char compileArgs[256];
-    sprintf(compileArgs, "-D CELLS_PER_ROW=%d -D CELLS_CURRENT=%lu -D ANTI=%d -D ITERATIONS_MAX=%d -D CHECK=true", cellsPerRow, count, (cl_uint)*anti, *iterationsMax);
+// bytes of one of the kernel's Reals
+static size_t realSize(KernelPrecision precision) {
+    switch (precision) {
+        case PRECISION_DOUBLE: return sizeof(cl_double);
+        case PRECISION_FLOAT_FLOAT: return sizeof(cl_float2);
+        default: return sizeof(cl_float);
+    }
+}
 
-    err = clBuildProgram(program, 1, &deviceId, compileArgs, NULL, NULL);
-    if (err != CL_SUCCESS) {
+// writes value as one of the kernel's Reals, a float-float being the nearest float followed by what it leaves over
+static void packReal(long double value, KernelPrecision precision, unsigned char *destination) {
+    if (precision == PRECISION_DOUBLE) {
+        const cl_double real = (cl_double)value;
+        memcpy(destination, &real, sizeof(real));
+    } else if (precision == PRECISION_FLOAT_FLOAT) {
+        cl_float2 real;
+        real.s[0] = (cl_float)value;
+        real.s[1] = (cl_float)(value - real.s[0]);
+        memcpy(destination, &real, sizeof(real));
+    } else {
+        const cl_float real = (cl_float)value;
+        memcpy(destination, &real, sizeof(real));
+    }
+}
+
+// the matrices of the projected views as the kernel's Scalars, i.e doubles in double precision and floats otherwise.
+// The kernel takes the buffer whether or not it has views, so it always holds at least one matrix
+static cl_mem createProjections(cl_context context, const std::vector<Projection> &projections, KernelPrecision precision) {
+    std::vector<cl_double> doubles(std::max<size_t>(projections.size(), 1) * 8, 0);
+
+    for (size_t v = 0; v < projections.size(); ++v)
+        std::copy(&projections[v].matrix[0][0], &projections[v].matrix[0][0] + 8, &doubles[v * 8]);
+
+    if (precision == PRECISION_DOUBLE)
+        return clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_double) * doubles.size(), doubles.data(), NULL);
+
+    std::vector<cl_float> floats(doubles.begin(), doubles.end());
+
+    return clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_float) * floats.size(), floats.data(), NULL);
+}
+
+static cl_int setRealArg(cl_kernel kernel, cl_uint index, long double value, KernelPrecision precision) {
+    unsigned char real[sizeof(cl_double) > sizeof(cl_float2) ? sizeof(cl_double) : sizeof(cl_float2)];
+    packReal(value, precision, real);
+
+    return clSetKernelArg(kernel, index, realSize(precision), real);
+}
+
+cl_program OpenCLKernelHelper::buildProgram(const std::string &compileArgs, int *err) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::map<std::string, cl_program>::iterator found = programs.find(compileArgs);
+    if (found != programs.end()) {
+        *err = 0;
+        return found->second;
+    }
+
+    const char *text = source.c_str();
+
+    cl_program program = clCreateProgramWithSource(context, 1, &text, NULL, err);
+    if (!program || *err != CL_SUCCESS) {
+        std::cout << "Failed to create program from source. Check OpenCL install or use without -o option" << std::endl;
+        *err = 1;
+        return NULL;
+    }
+
+    *err = clBuildProgram(program, 1, &deviceId, compileArgs.c_str(), NULL, NULL);
+    if (*err != CL_SUCCESS) {
         size_t len;
         char buffer[8192];
 
         std::cout << "Failed to build program executable. Check OpenCL install or use without -o option" << std::endl;
         clGetProgramBuildInfo(program, deviceId, CL_PROGRAM_BUILD_LOG, sizeof(char) * 8192, buffer, &len);
         std::cout << buffer << std::endl;
-        exit(1);
+
+        clReleaseProgram(program);
+        *err = 1;
+        return NULL;
+    }
+
+    programs[compileArgs] = program;
+
+    return program;
+}
+
+cl_command_queue OpenCLKernelHelper::acquireQueue() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!idleQueues.empty()) {
+        cl_command_queue commands = idleQueues.back();
+        idleQueues.pop_back();
+        return commands;
+    }
+
+    cl_int err;
+    cl_command_queue commands = clCreateCommandQueue(context, deviceId, 0, &err);
+    if (!commands)
+        std::cout << "Failed to create a command queue. Check OpenCL install or use without -o option" << std::endl;
+
+    return commands;
+}
+
+void OpenCLKernelHelper::releaseQueue(cl_command_queue commands) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    idleQueues.push_back(commands);
+}
+
+int OpenCLKernelHelper::calculateCells(Histogram* histogram, std::vector<Histogram> *projected, const RenderConfig &config, const SeedGrid &grid, SeedCache* cache, Statistics* stats) {
+    return calculateCells(histogram, projected, config, grid, cache, stats, 0, grid.rows);
+}
+
+int OpenCLKernelHelper::calculateCells(Histogram* histogram, std::vector<Histogram> *projected, const RenderConfig &config, const SeedGrid &grid, SeedCache* cache, Statistics* stats, unsigned int firstSeedRow, unsigned int lastSeedRow, unsigned int *committedRows) {
+    KernelRender render;
+    render.stats = stats;
+    render.verbose = firstSeedRow == 0 && lastSeedRow >= grid.rows;
+    render.projections = NULL;
+    render.minReal = histogram->minReal;
+    render.minImag = histogram->minImag;
+    render.cellWidth = histogram->cellWidth;
+    render.mirrorCount = 0; // only set for the count pass, as checking does not bin anything
+    render.rows = histogram->height;
+    render.committedRows = 0;
+
+    stats->backend = "opencl";
+    stats->iterationsTracked = false;
+
+    double phaseStart = Statistics::now();
+
+    // seeds of every tile that survived culling, held as doubles until they are converted to the kernel's precision,
+    // with the seeds that stand in for their conjugates first so
+    // that the kernel only needs to know how many of them there are. Seeds already in the cache, or classified by
+    // the interior check, skip the check pass
+    std::vector<double> seeds;
+    std::vector<unsigned long int> seedIndices;
+    std::vector<double> knownSeeds[2]; // mirrored and not, of seeds known to contribute
+
+    cl_uint mirrorCount = 0;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (unsigned int i = firstSeedRow; i < std::min(lastSeedRow, grid.rows); ++i) {
+            if (!grid.rowActive(i))
+                continue;
+
+            for (unsigned int j = 0; j < grid.columns; ++j) {
+                SeedKind kind = grid.kind(i, j);
+
+                if (kind == SEED_SKIPPED || (kind == SEED_MIRRORED) != (pass == 0))
+                    continue;
+
+                ComplexNumber c = grid.seed(i, j);
+                unsigned long int index = grid.index(i, j);
+
+                SeedClass known = grid.classification(i, j);
+
+                std::vector<double> *destination = &seeds;
+
+                if (cache && (cache->state(index) & SEED_CHECKED)) {
+                    if (!(cache->state(index) & SEED_CONTRIBUTING))
+                        continue;
+
+                    destination = &knownSeeds[pass];
+                } else if (known != SEED_UNCLASSIFIED) {
+                    // already found by the interior check, so the check pass' flag is as good as known
+                    const bool contributes = (known == SEED_ESCAPES) != config.anti;
+
+                    if (cache)
+                        cache->record(index, contributes);
+
+                    if (!contributes)
+                        continue;
+
+                    destination = &knownSeeds[pass];
+                } else
+                    seedIndices.push_back(index);
+
+                destination->push_back((double)c.real);
+                destination->push_back((double)c.imag);
+            }
+        }
+
+        if (pass == 0)
+            mirrorCount = (cl_uint)(seeds.size() / 2);
+    }
+
+    stats->addPhase("allocation", Statistics::now() - phaseStart);
+
+    const int err = countSeeds(&render, histogram, projected, config, &seeds, seedIndices, knownSeeds, mirrorCount, cache, grid.count());
+
+    if (committedRows)
+        *committedRows = render.committedRows;
+
+    return err;
+}
+
+int OpenCLKernelHelper::calculateSeeds(Histogram *histogram, std::vector<Histogram> *projected, const RenderConfig &config, std::vector<double> seeds, cl_uint mirrorCount, Statistics *stats) {
+    KernelRender render;
+    render.stats = stats;
+    render.verbose = false;
+    render.projections = NULL;
+    render.minReal = histogram->minReal;
+    render.minImag = histogram->minImag;
+    render.cellWidth = histogram->cellWidth;
+    render.mirrorCount = 0;
+    render.rows = histogram->height;
+    render.committedRows = 0;
+
+    stats->backend = "opencl";
+    stats->iterationsTracked = false;
+
+    std::vector<double> knownSeeds[2];
+
+    return countSeeds(&render, histogram, projected, config, &seeds, std::vector<unsigned long int>(), knownSeeds, mirrorCount, NULL, seeds.size() / 2);
+}
+
+KernelLayout OpenCLKernelHelper::plan(const RenderConfig &config, KernelPrecision precision, unsigned int width, unsigned int height, unsigned int views, unsigned long int checkedSeeds, unsigned long int evaluatedSeeds) const {
+    KernelLayout layout;
+    layout.precision = precision;
+    layout.realBytes = (unsigned int)realSize(precision);
+    layout.iterationsMax = config.iterationsMax;
+
+    if (layout.iterationsMax == 0) {
+        // the estimation was found for square grids of seeds, so is given the side of an equivalent square
+        layout.iterationsMax = (unsigned int)(3.28E11 * pow(sqrt((double)std::max(evaluatedSeeds, 1UL)), -2.06));
+
+        if (config.anti)
+            layout.iterationsMax = (unsigned int) ceil(layout.iterationsMax / 8);
+
+        layout.iterationsMax = std::max(layout.iterationsMax, 1u);
+    }
+
+    // 1000-500 maximum for 6001
+    // ~5500 maximum for 2001
+    // >7500 maximum for 501
+
+    // the device's buffers are limited by the largest allocation it allows, and by the memory budget, half of
+    // which goes to the seeds and half to a band of the histogram and of each of the views
+    unsigned long long budget = maxAllocation;
+    if (config.maxMemory != 0)
+        budget = std::min(budget, config.maxMemory / 2);
+
+    layout.chunkSeeds = (cl_uint)std::max(1ULL, std::min((unsigned long long)std::max(checkedSeeds, 1UL), budget / (4 * realSize(precision) + sizeof(cl_uint))));
+    layout.bandRows = (unsigned int)std::max(1ULL, std::min((unsigned long long)height, budget / (sizeof(cl_uint) * width * (views + 1))));
+
+    // every launch holds the seeds and the current points of a chunk, next to the check pass' flags or the count
+    // pass' band of counts, and the matrices of the views, which are at most doubles
+    const unsigned long long chunkBytes = 4 * realSize(precision) * (unsigned long long)layout.chunkSeeds;
+    const unsigned long long countBytes = sizeof(cl_uint) * (unsigned long long)layout.bandRows * width * (views + 1);
+
+    layout.deviceBytes = chunkBytes + std::max(sizeof(cl_uint) * (unsigned long long)layout.chunkSeeds, countBytes) + sizeof(cl_double) * 8 * std::max(views, 1u);
+
+    return layout;
+}
+
+int OpenCLKernelHelper::layout(const RenderConfig &config, unsigned int width, unsigned int height, unsigned long int checkedSeeds, unsigned long int evaluatedSeeds, KernelLayout *result) {
+    if (initialise() != 0)
+        return 1;
+
+    *result = plan(config, resolvePrecision(config.precision), width, height, (unsigned int)config.projections.size(), checkedSeeds, evaluatedSeeds);
+
+    return 0;
+}
+
+int OpenCLKernelHelper::countSeeds(KernelRender *render, Histogram *histogram, std::vector<Histogram> *projected, const RenderConfig &config, std::vector<double> *seedList, const std::vector<unsigned long int> &seedIndices, std::vector<double> knownSeeds[2], cl_uint mirrorCount, SeedCache *cache, unsigned long int seedTotal) {
+    std::vector<double> &seeds = *seedList;
+    Statistics *stats = render->stats;
+
+    double phaseStart = Statistics::now();
+
+    const cl_uint seedCount = (cl_uint)(seeds.size() / 2);
+    const cl_uint evaluatedCount = seedCount + (cl_uint)((knownSeeds[0].size() + knownSeeds[1].size()) / 2);
+
+    const unsigned int views = projected ? (unsigned int)projected->size() : 0;
+
+    stats->addPhase("allocation", Statistics::now() - phaseStart);
+    phaseStart = Statistics::now();
+
+    // only the first render through this helper pays for the platform, context and source loading
+    if (initialise() != 0)
+        return 1;
+
+    render->precision = resolvePrecision(config.precision);
+
+    if (render->verbose && config.precision == PRECISION_DOUBLE && render->precision != PRECISION_DOUBLE)
+        std::cout << deviceName << " has no fp64, using float-float instead" << std::endl;
+
+    if (render->verbose)
+        printf("Using %u-bit (%s) floating point precision on %s\n", precisionBits(render->precision), precisionName(render->precision), deviceName.c_str());
+
+    const KernelLayout layout = plan(config, render->precision, histogram->width, histogram->height, views, seedCount, evaluatedCount);
+
+    render->iterationsMax = layout.iterationsMax;
+
+    if (render->verbose)
+        std::cout << "Iterations per group := " << render->iterationsMax << std::endl;
+
+    render->commands = acquireQueue();
+    if (!render->commands)
+        return 1;
+
+    stats->addPhase("setup", Statistics::now() - phaseStart);
+    phaseStart = Statistics::now();
+
+    int err;
+
+    // the degree is built into the kernel, whole degrees being unrolled like on the CPU
+    const Power power(config.power, config.cycles);
+
+    // grows with every define, so is built up rather than printed into a fixed buffer
+    std::ostringstream powerDefines;
+    powerDefines << std::setprecision(17) << "-D POWER=" << power.integer << " -D DEGREE=" << power.degree << " -D BAILOUT_SQUARED=" << power.bailoutSquared << " -D CYCLES=" << (int)config.cycles << " -D DOUBLE=" << (int)(render->precision == PRECISION_DOUBLE) << " -D FLOAT_FLOAT=" << (int)(render->precision == PRECISION_FLOAT_FLOAT);
+
+    const std::string powerArgs = powerDefines.str();
+
+    render->projections = createProjections(context, config.projections, render->precision);
+    if (!render->projections) {
+        std::cout << "Failed to allocate device memory. Check OpenCL install or use lower resolution or iteration values" << std::endl;
+        releaseQueue(render->commands);
+        return 1;
     }
 
-    kernelCheck = clCreateKernel(program, KERNEL_FUNCTION_NAME, &err);
+    // Build the program executable for running check kernel, which has no views to bin into
+    std::string compileArgs = "-D WIDTH=" + std::to_string(histogram->width) + " -D ANTI=" + std::to_string((cl_uint)config.anti) + " -D CHECK=true -D VIEWS=0 " + powerArgs;
+
+    cl_program program = buildProgram(compileArgs, &err);
+    cl_kernel kernelCheck = err == 0 ? clCreateKernel(program, KERNEL_FUNCTION_NAME, &err) : NULL;
     if (!kernelCheck || err != CL_SUCCESS) {
         std::cout << "Failed to create check kernel. Check OpenCL install or use without -o option" << std::endl;
-        exit(1);
+        clReleaseMemObject(render->projections);
+        releaseQueue(render->commands);
+        return 1;
     }
 
-    cl_uint* pointCorrectlyEscapes = new cl_uint[count];
+    stats->addPhase("build", Statistics::now() - phaseStart);
 
-    std::cout << "Memory successfully yoinked" << std::endl;
+    if (render->verbose)
+        std::cout << "Memory successfully yoinked" << std::endl;
 
-    const unsigned int iterationGroups = *iterations / *iterationsMax;
-    const unsigned int iterationFinal = *iterations - *iterationsMax * iterationGroups;
-    bool extraGroup = *iterations > (*iterationsMax * iterationGroups);
+    phaseStart = Statistics::now();
 
-    // check which coords have to be ran to find correct buddhabrot
-    for (unsigned int i = 0; i < iterationGroups; ++i) {
-        runKernel(&context, &commands, &kernelCheck, &deviceId, &originalCells, &interimResultsCheck, &pointCorrectlyEscapes, iterationsMax, false);
+    const cl_uint chunkSeeds = layout.chunkSeeds;
+    const unsigned int bandRows = layout.bandRows;
 
-        std::cout << '\t' << i << '/' << (extraGroup ? iterationGroups : (iterationGroups - 1)) << std::endl;
-    }
+    // check which seeds have to be ran to find correct buddhabrot, a chunk of seeds at a time
+    std::vector<cl_uint> pointCorrectlyEscapes(seedCount);
+    cl_mem flags = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_uint) * chunkSeeds, NULL, NULL);
+
+    err = flags ? 0 : 1;
+
+    for (cl_uint start = 0; err == 0 && start < seedCount; start += chunkSeeds) {
+        cl_uint chunk = std::min(chunkSeeds, seedCount - start);
+
+        if (render->verbose && seedCount > chunkSeeds)
+            std::cout << "Seeds " << start << '-' << (start + chunk) << '/' << seedCount << std::endl;
+
+        // every group of iterations adds the length it advanced each orbit by to the flags, so they start from zero
+        const cl_uint zero = 0;
+        err = clEnqueueFillBuffer(render->commands, flags, &zero, sizeof(cl_uint), 0, sizeof(cl_uint) * chunk, 0, NULL, NULL);
+        if (err != CL_SUCCESS)
+            std::cout << "Failed to clear the check pass' flags: " << err << ". Check OpenCL install or use without -o option" << std::endl;
 
-    if (extraGroup) {
-        runKernel(&context, &commands, &kernelCheck, &deviceId, &originalCells, &interimResultsCheck, &pointCorrectlyEscapes, &iterationFinal, false);
+        if (err == 0)
+            err = runPass(render, kernelCheck, &seeds[start * 2], chunk, flags, config);
 
-        std::cout << '\t' << iterationGroups << '/' << iterationGroups << std::endl;
+        if (err == 0) {
+            err = clEnqueueReadBuffer(render->commands, flags, CL_TRUE, 0, sizeof(cl_uint) * chunk, &pointCorrectlyEscapes[start], 0, NULL, NULL);
+            if (err != CL_SUCCESS)
+                std::cout << "Error: Failed to read output array: " << err << std::endl;
+        }
     }
 
+    if (flags)
+        clReleaseMemObject(flags);
     clReleaseKernel(kernelCheck);
-    delete[] interimResultsCheck;
-    delete[] originalCells;
 
-    // Build the program executable for running count kernel
-    unsigned int pointsThatCorrectlyEscape = 0;
+    if (err != 0) {
+        clReleaseMemObject(render->projections);
+        releaseQueue(render->commands);
+        return 1;
+    }
 
-    cl_uint* positionsOfCorrect = new cl_uint[inputCount];
+    stats->addPhase("check", Statistics::now() - phaseStart);
+    stats->total.orbitsEvaluated += seedCount;
 
-    for (unsigned int i = 0; i < cellsPerRow; ++i) {
-        for (unsigned int j = 0; j < cellsPerRow; ++j) {
-            if (pointCorrectlyEscapes[i * cellsPerRow + j]) {
-                pointsThatCorrectlyEscape += 1;
+    phaseStart = Statistics::now();
 
-                positionsOfCorrect[pointsThatCorrectlyEscape * 2 + 0] = i;
-                positionsOfCorrect[pointsThatCorrectlyEscape * 2 + 1] = j;
-            }
+    // make new list of seeds with only those that escape correctly, keeping the mirrored seeds first. Within the
+    // mirrored and the plain seeds, they are ordered by how long their orbits were in the check pass, so that each
+    // work-group of the count pass gets orbits of about the same cost. Every seed bins its own orbit wherever it is
+    // in the list, so only the split between mirrored and plain seeds has to be kept. The seeds known to
+    // contribute without being checked have no length to go by, so follow the checked ones
+    std::vector<double> pointsThatEscape;
+    std::vector<cl_uint> order;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        order.clear();
+
+        for (cl_uint i = pass == 0 ? 0 : mirrorCount; i < (pass == 0 ? mirrorCount : seedCount); ++i) {
+            const bool contributes = (pointCorrectlyEscapes[i] & CHECK_CONTRIBUTES) != 0;
+
+            if (contributes)
+                order.push_back(i);
+
+            if (cache)
+                cache->record(seedIndices[i], contributes);
+        }
+
+        // stable, so that seeds of the same length stay in the order of the grid
+        std::stable_sort(order.begin(), order.end(), [&](cl_uint a, cl_uint b) {
+            return (pointCorrectlyEscapes[a] & CHECK_LENGTH) < (pointCorrectlyEscapes[b] & CHECK_LENGTH);
+        });
+
+        for (cl_uint i : order) {
+            pointsThatEscape.push_back(seeds[i * 2 + 0]);
+            pointsThatEscape.push_back(seeds[i * 2 + 1]);
         }
+
+        pointsThatEscape.insert(pointsThatEscape.end(), knownSeeds[pass].begin(), knownSeeds[pass].end());
+        knownSeeds[pass] = std::vector<double>();
+
+        if (pass == 0)
+            render->mirrorCount = (cl_uint)(pointsThatEscape.size() / 2);
     }
 
-    delete[] pointCorrectlyEscapes;
+    const cl_uint pointsThatCorrectlyEscape = (cl_uint)(pointsThatEscape.size() / 2);
 
-    std::cout << "Correctly escaping points found := " << pointsThatCorrectlyEscape << '/' << count << std::endl;
+    seeds = std::vector<double>();
+    pointCorrectlyEscapes = std::vector<cl_uint>();
+    order = std::vector<cl_uint>();
 
-    sprintf(compileArgs, "-D CELLS_PER_ROW=%d -D CELLS_CURRENT=%d -D ANTI=%d -D ITERATIONS_MAX=%d -D CHECK=false", cellsPerRow, pointsThatCorrectlyEscape, (cl_uint)*anti, *iterationsMax);
+    if (render->verbose)
+        std::cout << "Correctly escaping points found := " << pointsThatCorrectlyEscape << '/' << seedTotal << std::endl;
 
-    err = clBuildProgram(program, 1, &deviceId, compileArgs, NULL, NULL);
-    if (err != CL_SUCCESS) {
-        size_t len;
-        char buffer[8192];
+    stats->addPhase("compaction", Statistics::now() - phaseStart);
+    stats->total.contributingSeeds += pointsThatCorrectlyEscape;
 
-        std::cout << "Failed to build program executable. Check OpenCL install or use without -o option" << std::endl;
-        clGetProgramBuildInfo(program, deviceId, CL_PROGRAM_BUILD_LOG, sizeof(char) * 8192, buffer, &len);
-        std::cout << buffer << std::endl;
-        exit(1);
-    }
+    phaseStart = Statistics::now();
+
+    // Build the program executable for running count kernel
+    compileArgs = "-D WIDTH=" + std::to_string(histogram->width) + " -D ANTI=" + std::to_string((cl_uint)config.anti) + " -D CHECK=false -D VIEWS=" + std::to_string(views) + " " + powerArgs;
 
-    kernelCount = clCreateKernel(program, KERNEL_FUNCTION_NAME, &err);
+    program = buildProgram(compileArgs, &err);
+    cl_kernel kernelCount = err == 0 ? clCreateKernel(program, KERNEL_FUNCTION_NAME, &err) : NULL;
     if (!kernelCount || err != CL_SUCCESS) {
         std::cout << "Failed to create count kernel. Check OpenCL install or use without -o option" << std::endl;
-        exit(1);
+        clReleaseMemObject(render->projections);
+        releaseQueue(render->commands);
+        return 1;
     }
 
-    // make new interim results with only those that escape
-    Real* pointsThatEscape = new Real[pointsThatCorrectlyEscape * 2];
-    Real* interimResultsCount = new Real[pointsThatCorrectlyEscape * 2]();
+    stats->addPhase("build", Statistics::now() - phaseStart);
+    phaseStart = Statistics::now();
 
-    for (unsigned int i = 0; i < pointsThatCorrectlyEscape; ++i) {
-        Real realx = MIN_GPU.first + cellRealWidth * (cellsPerRow - 1 - positionsOfCorrect[i * 2 + 0]); // inverting iteration through cells on the x-axis so that the buddhabrot renders "sitting-down" -- more picturesque
-        Real realy = MIN_GPU.second + cellRealWidth * positionsOfCorrect[i * 2 + 1];
+    // use correctly escaping points to find all correctly visited points, a band of the histogram's rows at a
+    // time. Each band's counts are accumulated on the device across every chunk of seeds and group of
+    // iterations and only read back once the band is finished, the same band of every view following the
+    // viewport's
+    const cl_uint mirrorTotal = render->mirrorCount;
+    const unsigned int bands = (histogram->height + bandRows - 1) / bandRows;
 
-        pointsThatEscape[i * 2 + 0] = realx;
-        pointsThatEscape[i * 2 + 1] = realy;
-    }
+    std::vector<cl_uint> counts((unsigned long int)bandRows * histogram->width * (views + 1));
+    cl_mem countsGPU = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_uint) * counts.size(), NULL, NULL);
 
-    delete[] positionsOfCorrect;
+    err = countsGPU ? 0 : 1;
+    if (err != 0)
+        std::cout << "Failed to allocate device memory. Check OpenCL install or use lower resolution or iteration values" << std::endl;
 
-    // use correctly escaping points to find all correctly visited points
-    inputCount = pointsThatCorrectlyEscape * 2;
+    double countSeconds = 0, reductionSeconds = 0;
 
-    cl_uint* counts = new cl_uint[count];
+    for (unsigned int band = 0; err == 0 && band < bands; ++band) {
+        const unsigned int firstRow = band * bandRows;
+        const unsigned int rows = std::min(bandRows, histogram->height - firstRow);
+        const unsigned long int bandSize = (unsigned long int)rows * histogram->width;
 
-    for (unsigned int i = 0; i < iterationGroups; ++i) {
-        runKernel(&context, &commands, &kernelCount, &deviceId, &pointsThatEscape, &interimResultsCount, &counts, iterationsMax, true);
+        if (render->verbose && bands > 1)
+            std::cout << "Rows " << firstRow << '-' << (firstRow + rows) << '/' << histogram->height << std::endl;
 
-        std::cout << '\t' << i << '/' << (extraGroup ? iterationGroups : (iterationGroups - 1)) << std::endl;
-    }
+        phaseStart = Statistics::now();
+
+        render->minReal = histogram->pixelReal(firstRow);
+        render->rows = rows;
+
+        const cl_uint zero = 0;
+        err = clEnqueueFillBuffer(render->commands, countsGPU, &zero, sizeof(cl_uint), 0, sizeof(cl_uint) * bandSize * (views + 1), 0, NULL, NULL);
+        if (err != CL_SUCCESS)
+            std::cout << "Failed to allocate device memory. Check OpenCL install or use lower resolution or iteration values" << std::endl;
+
+        for (cl_uint start = 0; err == 0 && start < pointsThatCorrectlyEscape; start += chunkSeeds) {
+            cl_uint chunk = std::min(chunkSeeds, pointsThatCorrectlyEscape - start);
+
+            // the mirrored seeds are the first mirrorTotal of all of them, so may end part way into a chunk
+            render->mirrorCount = mirrorTotal > start ? std::min(mirrorTotal - start, chunk) : 0;
 
-    if (extraGroup) {
-        runKernel(&context, &commands, &kernelCount, &deviceId, &pointsThatEscape, &interimResultsCount, &counts, &iterationFinal, true);
+            err = runPass(render, kernelCount, &pointsThatEscape[start * 2], chunk, countsGPU, config);
+        }
+
+        countSeconds += Statistics::now() - phaseStart;
+        phaseStart = Statistics::now();
+
+        if (err == 0) {
+            err = clEnqueueReadBuffer(render->commands, countsGPU, CL_TRUE, 0, sizeof(cl_uint) * bandSize * (views + 1), counts.data(), 0, NULL, NULL);
+            if (err != CL_SUCCESS)
+                std::cout << "Error: Failed to read output array: " << err << std::endl;
+        }
+
+        if (err == 0) {
+            const unsigned long int offset = (unsigned long int)firstRow * histogram->width;
+
+            for (unsigned int v = 0; v <= views; ++v) {
+                Histogram *target = v == 0 ? histogram : &(*projected)[v - 1];
+                const cl_uint *band = &counts[v * bandSize];
+
+                for (unsigned long int i = 0; i < bandSize; ++i) {
+                    if (band[i] != 0)
+                        target->add(offset + i, band[i]);
+
+                    stats->total.histogramIncrements += band[i];
+                }
 
-        std::cout << '\t' << iterationGroups << '/' << iterationGroups << std::endl;
+                target->flushRows(firstRow, rows);
+            }
+
+            render->committedRows = firstRow + rows;
+        }
+
+        reductionSeconds += Statistics::now() - phaseStart;
     }
 
-    clReleaseProgram(program);
+    stats->addPhase("count", countSeconds);
+    if (err == 0)
+        stats->addPhase("reduction", reductionSeconds);
+
+    if (countsGPU)
+        clReleaseMemObject(countsGPU);
+    clReleaseMemObject(render->projections);
     clReleaseKernel(kernelCount);
-    clReleaseCommandQueue(commands);
-    clReleaseContext(context);
-    clReleaseDevice(deviceId);
+    releaseQueue(render->commands);
 
-    delete[] pointsThatEscape;
-    delete[] interimResultsCount;
-    delete[] counts;
+    return err == 0 ? 0 : 1;
 }
 
 int loadTextFromFile(const char* filename, char** fileString, size_t* stringLength) {
@@ -256,7 +752,7 @@ int loadTextFromFile(const char* filename, char** fileString, size_t* stringLeng
     rewind(file); // reset the file pointer so that 'fread' reads from the front
     *fileString = (char*)malloc(length + 1);
     (*fileString)[length] = '\0';
-    fread(*fileString, sizeof(char), length, file);
+    length = fread(*fileString, sizeof(char), length, file);
     fclose(file);
 
     *stringLength = length;
@@ -264,84 +760,114 @@ int loadTextFromFile(const char* filename, char** fileString, size_t* stringLeng
     return 0;
 }
 
-void runKernel(cl_context* context, cl_command_queue* commands, cl_kernel* kernel, cl_device_id* deviceId, Real** originalPoints, Real** interimResults, cl_uint** pointCorrectlyEscapes, const unsigned int* iterations, bool countKernel) {
-    size_t global;
-    size_t local;
+int OpenCLKernelHelper::runPass(KernelRender* render, cl_kernel kernel, const double *seeds, cl_uint cellsCurrent, cl_mem output, const RenderConfig &config) {
+    const size_t seedsSize = (size_t)cellsCurrent * 2;
+
+    // nothing escapes correctly, e.g very low iterations for an anti-buddhabrot
+    if (cellsCurrent == 0)
+        return 0;
 
-    // Create the input and output arrays in device memory for our calculation
-    cl_mem inputOriginal = clCreateBuffer(*context, CL_MEM_READ_ONLY, sizeof(Real) * inputCount, NULL, NULL);
-    cl_mem inputCurrent = clCreateBuffer(*context, CL_MEM_READ_ONLY, sizeof(Real) * inputCount, NULL, NULL);
+    // Create the input arrays in device memory for our calculation, every orbit starting from z = 0
+    const size_t bytes = realSize(render->precision) * seedsSize;
 
-    cl_mem interimResultsGPU = clCreateBuffer(*context, CL_MEM_WRITE_ONLY, sizeof(Real) * inputCount, NULL, NULL);
-    cl_mem output = clCreateBuffer(*context, CL_MEM_WRITE_ONLY, sizeof(cl_uint) * count, NULL, NULL);
-    if (!inputOriginal || !inputCurrent || !interimResultsGPU || !output) {
+    cl_mem inputSeeds = clCreateBuffer(context, CL_MEM_READ_ONLY, bytes, NULL, NULL);
+    cl_mem inputCurrent = clCreateBuffer(context, CL_MEM_READ_WRITE, bytes, NULL, NULL);
+    if (!inputSeeds || !inputCurrent) {
         std::cout << "Failed to allocate device memory. Check OpenCL install or use lower resolution or iteration values" << std::endl;
-        exit(1);
+
+        if (inputSeeds)
+            clReleaseMemObject(inputSeeds);
+        if (inputCurrent)
+            clReleaseMemObject(inputCurrent);
+        return 1;
     }
 
-    cl_int err = clEnqueueWriteBuffer(*commands, inputCurrent, CL_TRUE, 0, sizeof(Real) * inputCount, *interimResults, 0, NULL, NULL);
-    err |= clEnqueueWriteBuffer(*commands, inputOriginal, CL_TRUE, 0, sizeof(Real) * inputCount, *originalPoints, 0, NULL, NULL);
-    if (err != CL_SUCCESS) {
+    std::vector<unsigned char> packed(bytes);
+    for (size_t i = 0; i < seedsSize; ++i)
+        packReal(seeds[i], render->precision, &packed[i * realSize(render->precision)]);
+
+    // zero is all zero bits in every precision
+    const cl_uint zero = 0;
+
+    cl_int err = clEnqueueWriteBuffer(render->commands, inputSeeds, CL_TRUE, 0, bytes, packed.data(), 0, NULL, NULL);
+    err |= clEnqueueFillBuffer(render->commands, inputCurrent, &zero, sizeof(cl_uint), 0, bytes, 0, NULL, NULL);
+    if (err != CL_SUCCESS)
         std::cout << "Failed to write to source array. Check OpenCL install or use without -o option" << std::endl;
-        exit(1);
+
+    // Set the arguments to our compute kernel, only the iterations change between groups
+    if (err == CL_SUCCESS) {
+        err = clSetKernelArg(kernel, 0, sizeof(cl_mem), &inputSeeds);
+        err |= clSetKernelArg(kernel, 1, sizeof(cl_mem), &inputCurrent);
+        err |= setRealArg(kernel, 2, render->minReal, render->precision);
+        err |= setRealArg(kernel, 3, render->minImag, render->precision);
+        err |= setRealArg(kernel, 4, render->cellWidth, render->precision);
+        err |= clSetKernelArg(kernel, 6, sizeof(cl_mem), &output);
+        err |= clSetKernelArg(kernel, 7, sizeof(cl_uint), &cellsCurrent);
+        err |= clSetKernelArg(kernel, 8, sizeof(cl_uint), &render->mirrorCount);
+        err |= clSetKernelArg(kernel, 9, sizeof(cl_uint), &render->rows);
+        err |= clSetKernelArg(kernel, 11, sizeof(cl_mem), &render->projections);
+
+        if (err != CL_SUCCESS)
+            std::cout << "Failed to set kernel arguments: " << err << std::endl;
+    }
+
+    const unsigned int iterationGroups = config.iterations / render->iterationsMax;
+    const unsigned int iterationFinal = config.iterations - render->iterationsMax * iterationGroups;
+    bool extraGroup = config.iterations > (render->iterationsMax * iterationGroups);
+
+    for (unsigned int i = 0; err == CL_SUCCESS && i < iterationGroups; ++i) {
+        err = runKernel(render, kernel, render->iterationsMax, config.iterations - render->iterationsMax * i, cellsCurrent);
+
+        if (render->verbose)
+            std::cout << '\t' << i << '/' << (extraGroup ? iterationGroups : (iterationGroups - 1)) << std::endl;
+    }
+
+    if (err == CL_SUCCESS && extraGroup) {
+        err = runKernel(render, kernel, iterationFinal, iterationFinal, cellsCurrent);
+
+        if (render->verbose)
+            std::cout << '\t' << iterationGroups << '/' << iterationGroups << std::endl;
     }
 
-    // Set the arguments to our compute kernel
-    err = 0;
-    err = clSetKernelArg(*kernel, 0, sizeof(cl_mem), &inputOriginal);
-    err |= clSetKernelArg(*kernel, 1, sizeof(cl_mem), &inputCurrent);
-    err |= clSetKernelArg(*kernel, 2, sizeof(Real), &(MIN_GPU.first));
-    err |= clSetKernelArg(*kernel, 3, sizeof(Real), &(MIN_GPU.second));
-    err |= clSetKernelArg(*kernel, 4, sizeof(Real), &cellRealWidth);
-    err |= clSetKernelArg(*kernel, 5, sizeof(cl_uint), iterations);
-    err |= clSetKernelArg(*kernel, 6, sizeof(cl_mem), &interimResultsGPU);
-    err |= clSetKernelArg(*kernel, 7, sizeof(cl_mem), &output);
+    clReleaseMemObject(inputSeeds);
+    clReleaseMemObject(inputCurrent);
+
+    return err == CL_SUCCESS ? 0 : 1;
+}
 
+int OpenCLKernelHelper::runKernel(KernelRender* render, cl_kernel kernel, unsigned int iterations, unsigned int iterationsLeft, cl_uint cellsCurrent) {
+    size_t global;
+    size_t local;
+
+    cl_int err = clSetKernelArg(kernel, 5, sizeof(cl_uint), &iterations);
+    err |= clSetKernelArg(kernel, 10, sizeof(cl_uint), &iterationsLeft);
     if (err != CL_SUCCESS) {
         std::cout << "Failed to set kernel arguments: " << err << std::endl;
-        exit(1);
+        return 1;
     }
 
-    err = clGetKernelWorkGroupInfo(*kernel, *deviceId, CL_KERNEL_WORK_GROUP_SIZE, sizeof(local), &local, NULL);
+    err = clGetKernelWorkGroupInfo(kernel, deviceId, CL_KERNEL_WORK_GROUP_SIZE, sizeof(local), &local, NULL);
     if (err != CL_SUCCESS) {
         std::cout << "Failed to retrieve kernel work group info: " << err << std::endl;
-        exit(1);
+        return 1;
     }
 
     // Execute the kernel
-    if ((inputCount / 2) % local == 0)
-        global = (inputCount / 2);
+    if (cellsCurrent % local == 0)
+        global = cellsCurrent;
     else
-        global = (size_t)(floor((inputCount / 2) / local) + 1) * local;
+        global = (size_t)(floor(cellsCurrent / local) + 1) * local;
 
-    err = clEnqueueNDRangeKernel(*commands, *kernel, 1, NULL, &global, &local, 0, NULL, NULL);
+    err = clEnqueueNDRangeKernel(render->commands, kernel, 1, NULL, &global, &local, 0, NULL, NULL);
     if (err) {
         std::cout << "Failed to execute kernel. Check OpenCL install or use without -o option" << std::endl;
-        exit(1);
-    }
-
-    clFinish(*commands);
-
-    err = clEnqueueReadBuffer(*commands, interimResultsGPU, CL_TRUE, 0, sizeof(Real) * inputCount, *interimResults, 0, NULL, NULL);
-    err |= clEnqueueReadBuffer(*commands, output, CL_TRUE, 0, sizeof(cl_uint) * count, *pointCorrectlyEscapes, 0, NULL, NULL);
-    if (err != CL_SUCCESS) {
-        std::cout << "Error: Failed to read output array: " << err << std::endl;
-        exit(1);
+        return 1;
     }
 
-    clReleaseMemObject(inputOriginal);
-    clReleaseMemObject(inputCurrent);
-    clReleaseMemObject(interimResultsGPU);
-    clReleaseMemObject(output);
+    render->stats->kernelLaunches++;
 
-    if (countKernel) {
-        for (unsigned int i = 0; i < cellsPerRow; ++i) {
-            for (unsigned int j = 0; j < cellsPerRow; ++j) {
-                (*g_cellsGPU)[i * cellsPerRow * 3 + j * 3 + 2] += (Real)(*pointCorrectlyEscapes)[i * cellsPerRow + j];
+    // waiting on every group keeps the device from being tied up long enough to hang
+    clFinish(render->commands);
 
-                if ((*g_cellsGPU)[i * cellsPerRow * 3 + j * 3 + 2] > *g_maxCount)
-                    *g_maxCount = (unsigned int) (*g_cellsGPU)[i * cellsPerRow * 3 + j * 3 + 2];
-            }
-        }
-    }
+    return 0;
 }
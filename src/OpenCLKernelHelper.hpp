@@ -1,6 +1,6 @@
 //===========================================================================//
 ///
-/// Copyright Jim Carty © 2020
+/// Copyright Jim Carty © 2020-2021
 ///
 /// This file is subject to the terms and conditions defined in file
 /// 'LICENSE.txt', which is part of this source code package.
@@ -16,28 +16,143 @@
     #include <CL/opencl.h>
 #endif
 
+#include "Histogram.hpp"
+#include "RenderConfig.hpp"
+#include "SeedCache.hpp"
+#include "SeedGrid.hpp"
+#include "Statistics.hpp"
+
+#include <map>
+#include <mutex>
+#include <string>
 #include <tuple>
+#include <vector>
 
 #ifndef KernelHelper_hpp
 #define KernelHelper_hpp
 
-#if DOUBLE_SUPPORT_AVAILABLE
-    // double
-    typedef double Real;
-    #define PRECISION (64)
-#else
-    // float
-    typedef float Real;
-    #define PRECISION (32)
-#endif
+// how the passes over a render's seeds are split up, so that a render can be sized up before it is ran
+struct KernelLayout {
+    KernelPrecision precision;      // never PRECISION_AUTO
+    unsigned int realBytes;         // of each part of a seed, as sent to the device
+    unsigned int iterationsMax;     // iterations of every orbit per kernel launch
+    unsigned int chunkSeeds;        // seeds per kernel launch
+    unsigned int bandRows;          // rows of the histogram, and of each view, counted on the device at a time
+    unsigned long long deviceBytes; // most device memory held at once, by either pass
+};
 
 static const char *KERNEL_FILENAME = "src/EscapeKernel.cl";
 static const char *KERNEL_FUNCTION_NAME = "escape";
 
+// the check pass' output for a seed, whether it contributes in the top bit and how many times its orbit was
+// advanced in the bits below, as defined in the kernel
+static const cl_uint CHECK_CONTRIBUTES = 0x80000000u;
+static const cl_uint CHECK_LENGTH = 0x7FFFFFFFu;
+
 int loadTextFromFile(const char *filename, char **fileString, size_t *stringLength);
 
-void calculateCells(Real **g_cellsGPU, unsigned int *g_maxCount, unsigned int *iterations, unsigned int *cellsPerRow, const std::pair<long double, long double> *min, long double *cellRealWidth, bool *anti, unsigned int *iterationsMax);
+// owns the OpenCL context of one device, a pool of command queues and every program built so far, so that they
+// stay warm between renders. Any number of renders can run through the same helper at once, each one taking its
+// own queue and kernels for the duration of the render
+class OpenCLKernelHelper {
+private:
+    // everything that belongs to a single call of calculateCells
+    struct KernelRender {
+        Statistics *stats;
+
+        KernelPrecision precision; // never PRECISION_AUTO
+
+        long double minReal;
+        long double minImag;
+        long double cellWidth;
+
+        cl_uint mirrorCount; // leading seeds whose conjugates are also binned
+        cl_uint rows;        // rows in the current band of the histogram, starting from minReal
+
+        unsigned int committedRows; // leading rows of the histogram, and of each view, already added to
+
+        unsigned int iterationsMax;
+
+        bool verbose; // a whole render rather than a chunk of one, so its progress is worth printing
+
+        cl_mem projections; // matrix of every projected view, as Scalars of the kernel's precision
+
+        cl_command_queue commands;
+    };
+
+    int deviceIndex; // out of every device of every platform, -1 for the first GPU
+
+    cl_platform_id platformId;
+    cl_device_id deviceId;
+    cl_context context;
+
+    std::string deviceName;
+    bool doubleSupported; // the device has cl_khr_fp64 or cl_amd_fp64
+
+    cl_ulong maxAllocation; // largest single buffer the device allows
+
+    std::vector<cl_command_queue> idleQueues;
+    std::map<std::string, cl_program> programs;
+
+    std::string source;
+
+    bool initialised;
+    int initialiseResult;
+
+    std::mutex mutex;
+
+    int initialise();
+
+    cl_program buildProgram(const std::string &compileArgs, int *err);
+    cl_command_queue acquireQueue();
+    void releaseQueue(cl_command_queue commands);
+
+    // the check, compaction and count passes over seeds, the first mirrorCount of which also bin their conjugates.
+    // Compaction orders the contributing seeds by the length of their orbits in the check pass, so that the count
+    // pass' work-groups are not held up by a few long orbits among short ones. seedIndices are where the seeds being
+    // checked are in the cache, and knownSeeds the mirrored and plain seeds already known to contribute, which go
+    // straight to the count pass. seedTotal is only printed
+    int countSeeds(KernelRender *render, Histogram *histogram, std::vector<Histogram> *projected, const RenderConfig &config, std::vector<double> *seeds, const std::vector<unsigned long int> &seedIndices, std::vector<double> knownSeeds[2], cl_uint mirrorCount, SeedCache *cache, unsigned long int seedTotal);
+
+    // checkedSeeds go through the check pass, and evaluatedSeeds through either pass
+    KernelLayout plan(const RenderConfig &config, KernelPrecision precision, unsigned int width, unsigned int height, unsigned int views, unsigned long int checkedSeeds, unsigned long int evaluatedSeeds) const;
+
+    int runPass(KernelRender *render, cl_kernel kernel, const double *seeds, cl_uint cellsCurrent, cl_mem output, const RenderConfig &config);
+    int runKernel(KernelRender *render, cl_kernel kernel, unsigned int iterations, unsigned int iterationsLeft, cl_uint cellsCurrent);
+
+public:
+    OpenCLKernelHelper(int device = -1) : deviceIndex(device), platformId(NULL), deviceId(NULL), context(NULL), doubleSupported(false), maxAllocation(0), initialised(false), initialiseResult(0) {};
+    ~OpenCLKernelHelper();
+
+    // process-wide helper of the device, shared by every Renderer that is not given one explicitly
+    static OpenCLKernelHelper *shared(int device = -1);
+
+    // name and type of every device of every platform, in the order --device counts them
+    static std::vector<std::string> devices();
+
+    // the precision that a render asking for requested gets on this device, doubles falling back to float-float
+    // on devices without fp64
+    KernelPrecision resolvePrecision(KernelPrecision requested);
+
+    // bits of a precision as printed and as told apart in the seed cache, 32 for float, 64 for double and 48 for
+    // float-float, whose two significands of 24 bits make up close to 48 bits of precision
+    static unsigned int precisionBits(KernelPrecision precision);
+
+    // cache may be NULL, otherwise the seeds it knows about skip the check pass and the rest are recorded in it.
+    // projected holds a histogram for each of config.projections, binned in the same pass as histogram
+    int calculateCells(Histogram *histogram, std::vector<Histogram> *projected, const RenderConfig &config, const SeedGrid &grid, SeedCache *cache, Statistics *stats);
+
+    // only the seeds of rows firstSeedRow up to lastSeedRow of the grid, adding to whatever the histograms hold. The
+    // histograms are added to a band of rows at a time, so on failure committedRows, when given, is set to how many
+    // of their leading rows already hold these seeds' counts
+    int calculateCells(Histogram *histogram, std::vector<Histogram> *projected, const RenderConfig &config, const SeedGrid &grid, SeedCache *cache, Statistics *stats, unsigned int firstSeedRow, unsigned int lastSeedRow, unsigned int *committedRows = NULL);
+
+    // the layout that calculateCells would use for a render with as many seeds, without running it
+    int layout(const RenderConfig &config, unsigned int width, unsigned int height, unsigned long int checkedSeeds, unsigned long int evaluatedSeeds, KernelLayout *result);
 
-void runKernel(cl_context *context, cl_command_queue *commands, cl_kernel *kernel, cl_device_id *deviceId, Real **originalPoints, Real **interimResults, cl_uint **pointCorrectlyEscapes, const unsigned int *iterations, bool countKernel);
+    // seeds that are not on a grid, as real and imaginary parts one after another, the first mirrorCount of them
+    // also binning their conjugates. Adds to whatever the histograms hold
+    int calculateSeeds(Histogram *histogram, std::vector<Histogram> *projected, const RenderConfig &config, std::vector<double> seeds, cl_uint mirrorCount, Statistics *stats);
+};
 
 #endif // KernelHelper_hpp
@@ -0,0 +1,447 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Options.hpp"
+
+#include "Topology.hpp"
+
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <math.h>
+#include <sstream>
+#include <stdexcept>
+
+// reads count comma separated numbers, e.g a complex number as RE,IM
+static void parseNumbers(const std::string &arg, long double *numbers, unsigned int count) {
+    std::stringstream lineStream(arg);
+    std::string tmp;
+
+    for (unsigned int i = 0; i < count; ++i) {
+        if (!std::getline(lineStream, tmp, ','))
+            throw std::invalid_argument(arg);
+
+        numbers[i] = std::stold(tmp);
+    }
+}
+
+int parseOptions(const std::vector<std::string> &args, Options *options) {
+    RenderConfig &config = options->config;
+
+    int result = 0;
+
+    std::string tmp;
+    std::stringstream lineStream;
+
+    for (unsigned int i = 0; i < args.size(); ++i) {
+        const std::string &arg = args[i];
+
+        // every option other than the flags takes a value
+        bool flag = arg == "--halton" || arg == "-a" || arg == "-4" || arg == "-o" || arg == "-h" || arg == "--no-cull" || arg == "--no-interior" || arg == "--no-cycles" || arg == "--no-symmetry" || arg == "--pin" || arg == "--scatter" || arg == "--hybrid" || arg == "--pyramid" || arg == "--estimate";
+        if (arg.size() < 2 || arg[0] != '-' || (!flag && i + 1 >= args.size())) {
+            printf("Unknown option: %s\n", arg.c_str());
+            result = 1;
+            continue;
+        }
+
+        try {
+            switch (arg[1]) {
+                case 'a' :
+                    config.anti = true;
+                    break;
+
+                case 's' :
+                    options->save = true;
+                    options->saveFileName = args[++i];
+                    break;
+
+                case 'l' :
+                    options->load = true;
+                    options->loadFileName = args[++i];
+                    config.useGpu = true;
+                    break;
+
+                case '4' :
+                    config.alpha = true;
+                    break;
+
+                case 'o' :
+                    config.useGpu = true;
+                    break;
+
+                case 'w' :
+                    config.windowWidth = std::stoi(args[++i]);
+                    break;
+
+                case 'i' :
+                    config.iterations = std::stoi(args[++i]);
+                    break;
+
+                case 'm' :
+                    config.iterationsMax = std::stoi(args[++i]);
+                    break;
+
+                case 'c' :
+                    lineStream = std::stringstream(args[++i]);
+
+                    std::getline(lineStream, tmp, ',');
+                    config.colourR = (unsigned char)std::stoi(tmp);
+
+                    std::getline(lineStream, tmp, ',');
+                    config.colourG = (unsigned char)std::stoi(tmp);
+
+                    std::getline(lineStream, tmp, ',');
+                    config.colourB = (unsigned char)std::stoi(tmp);
+                    break;
+
+                case 't' :
+                    config.numThreads = (unsigned int)std::stoi(args[++i]);
+                    options->threadsGiven = true;
+                    break;
+
+                case 'h' :
+                    return -1;
+
+                case '-' :
+                    if (arg == "--stats") {
+                        options->stats = true;
+                        options->statsFileName = args[++i];
+                    } else if (arg == "--batch") {
+                        options->batch = true;
+                        options->batchFileName = args[++i];
+                    } else if (arg == "--estimate") {
+                        options->estimate = true;
+                    } else if (arg == "--serve") {
+                        options->serve = true;
+                        options->serveSocketName = args[++i];
+                    } else if (arg == "--height") {
+                        config.windowHeight = std::stoi(args[++i]);
+                    } else if (arg == "--aspect") {
+                        options->aspect = std::stod(args[++i]);
+                    } else if (arg == "--centre") {
+                        long double centre[2];
+                        parseNumbers(args[++i], centre, 2);
+
+                        config.centreReal = centre[0];
+                        config.centreImag = centre[1];
+                        options->centreGiven = true;
+                    } else if (arg == "--power") {
+                        config.power = std::stold(args[++i]);
+                    } else if (arg == "--zoom") {
+                        config.zoom = std::stold(args[++i]);
+                    } else if (arg == "--seeds") {
+                        config.seedsPerRow = std::stoi(args[++i]);
+                    } else if (arg == "--seed-domain") {
+                        long double domain[4];
+                        parseNumbers(args[++i], domain, 4);
+
+                        config.seedMin = { domain[0], domain[1] };
+                        config.seedMax = { domain[2], domain[3] };
+                        options->seedDomainGiven = true;
+                    } else if (arg == "--halton") {
+                        config.halton = true;
+                    } else if (arg == "--tolerance") {
+                        config.tolerance = std::stod(args[++i]);
+                    } else if (arg == "--time-limit") {
+                        config.timeLimit = std::stod(args[++i]);
+                    } else if (arg == "--projections") {
+                        std::vector<Projection> projections;
+                        if (readProjections(args[++i], &projections) != 0)
+                            throw std::invalid_argument(args[i]);
+
+                        config.projections.insert(config.projections.end(), projections.begin(), projections.end());
+                    } else if (arg == "--rotate") {
+                        const int frames = std::stoi(args[++i]);
+                        if (frames <= 0)
+                            throw std::invalid_argument(args[i]);
+
+                        std::vector<Projection> projections = rotationFrames(frames);
+                        config.projections.insert(config.projections.end(), projections.begin(), projections.end());
+                    } else if (arg == "--no-cull") {
+                        config.cull = false;
+                    } else if (arg == "--no-interior") {
+                        config.interior = false;
+                    } else if (arg == "--no-cycles") {
+                        config.cycles = false;
+                    } else if (arg == "--no-symmetry") {
+                        config.symmetry = false;
+                    } else if (arg == "--shard") {
+                        unsigned int index, count;
+                        if (sscanf(args[++i].c_str(), "%u/%u", &index, &count) != 2 || count == 0 || index >= count)
+                            throw std::invalid_argument(args[i]);
+
+                        config.shardIndex = index;
+                        config.shardCount = count;
+                    } else if (arg == "--scatter") {
+                        config.scatter = true;
+                    } else if (arg == "--pin") {
+                        config.pin = true;
+                    } else if (arg == "--png-depth") {
+                        config.pngDepth = std::stoi(args[++i]);
+                    } else if (arg == "--pyramid") {
+                        config.pyramid = true;
+                    } else if (arg == "--max-memory") {
+                        config.maxMemory = std::stoull(args[++i]) << 20;
+                    } else if (arg == "--hybrid") {
+                        config.hybrid = true;
+                    } else if (arg == "--device") {
+                        config.device = std::stoi(args[++i]);
+                    } else if (arg == "--precision") {
+                        const std::string &name = args[++i];
+
+                        if (name == "auto")
+                            config.precision = PRECISION_AUTO;
+                        else if (name == "float")
+                            config.precision = PRECISION_FLOAT;
+                        else if (name == "float-float")
+                            config.precision = PRECISION_FLOAT_FLOAT;
+                        else if (name == "double")
+                            config.precision = PRECISION_DOUBLE;
+                        else
+                            throw std::invalid_argument(name);
+                    } else if (arg == "--cache-dir") {
+                        config.cacheDir = args[++i];
+                    } else {
+                        printf("Unknown option: %s\n", arg.c_str());
+                        result = 1;
+                    }
+                    break;
+
+                default :
+                    printf("Unknown option: %s\n", arg.c_str());
+                    result = 1;
+                    break;
+            }
+        } catch (const std::exception&) {
+            printf("Invalid value for option: %s\n", arg.c_str());
+            result = 1;
+        }
+    }
+
+    if (options->aspect > 0 && config.windowHeight == 0)
+        config.windowHeight = std::max(1u, (unsigned int)round(config.windowWidth / options->aspect));
+
+    // refuse anything that cannot be drawn, rather than render something other than what was asked for
+    if (!(config.power > 1)) {
+        printf("Invalid power\n");
+        result = 1;
+    }
+
+    // every multibrot other than the regular one is centred on the origin and fits within |c| <= 2
+    if (config.power != 2) {
+        if (!options->centreGiven) {
+            config.centreReal = 0;
+            config.centreImag = 0;
+        }
+
+        if (!options->seedDomainGiven) {
+            config.seedMin = { -2, -2 };
+            config.seedMax = { 2, 2 };
+        }
+    }
+
+    if (config.windowWidth == 0 || config.zoom <= 0) {
+        printf("Invalid window size or zoom\n");
+        result = 1;
+    }
+
+    if (config.seedMin.first >= config.seedMax.first || config.seedMin.second >= config.seedMax.second) {
+        printf("Invalid seed domain\n");
+        result = 1;
+    }
+
+    if (config.tolerance < 0 || config.timeLimit < 0) {
+        printf("Invalid tolerance or time limit\n");
+        result = 1;
+    }
+
+    if (config.halton && config.tolerance == 0 && config.timeLimit == 0) {
+        printf("Halton sampling needs a tolerance or a time limit\n");
+        result = 1;
+    }
+
+    // every shard would stop after a different number of seeds, so their histograms could not be summed
+    if (config.halton && config.shardCount > 1) {
+        printf("Halton sampling cannot be sharded\n");
+        result = 1;
+    }
+
+    // how long sampling runs depends on when the image settles, which is only known by running it
+    if (options->estimate && config.halton) {
+        printf("Halton sampling cannot be estimated\n");
+        result = 1;
+    }
+
+    if (config.pngDepth != 8 && config.pngDepth != 16) {
+        printf("Invalid png depth\n");
+        result = 1;
+    }
+
+    return result;
+}
+
+bool sameHistogram(const Options &a, const Options &b) {
+    if (a.load || b.load)
+        return a.load && b.load && a.loadFileName == b.loadFileName && a.config.windowWidth == b.config.windowWidth && a.config.height() == b.config.height();
+
+    return a.config.windowWidth == b.config.windowWidth &&
+        a.config.height() == b.config.height() &&
+        a.config.centreReal == b.config.centreReal &&
+        a.config.centreImag == b.config.centreImag &&
+        a.config.zoom == b.config.zoom &&
+        a.config.seedMin == b.config.seedMin &&
+        a.config.seedMax == b.config.seedMax &&
+        a.config.seedColumns() == b.config.seedColumns() &&
+        a.config.halton == b.config.halton &&
+        (!a.config.halton || (a.config.tolerance == b.config.tolerance && a.config.timeLimit == b.config.timeLimit)) &&
+        a.config.cull == b.config.cull &&
+        a.config.projections == b.config.projections &&
+        a.config.interiorCheck() == b.config.interiorCheck() &&
+        a.config.cycles == b.config.cycles &&
+        a.config.symmetric() == b.config.symmetric() &&
+        a.config.shardIndex == b.config.shardIndex &&
+        a.config.shardCount == b.config.shardCount &&
+        a.config.iterations == b.config.iterations &&
+        a.config.power == b.config.power &&
+        a.config.anti == b.config.anti &&
+        a.config.useGpu == b.config.useGpu &&
+        a.config.hybrid == b.config.hybrid &&
+        a.config.device == b.config.device &&
+        a.config.precision == b.config.precision;
+}
+
+std::vector<std::string> splitArguments(const std::string &line) {
+    std::vector<std::string> args;
+    std::string current;
+
+    bool quoted = false;
+    bool inArgument = false;
+
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            inArgument = true;
+        } else if (!quoted && (c == ' ' || c == '\t' || c == '\r')) {
+            if (inArgument)
+                args.push_back(current);
+
+            current.clear();
+            inArgument = false;
+        } else {
+            current += c;
+            inArgument = true;
+        }
+    }
+
+    if (inArgument)
+        args.push_back(current);
+
+    return args;
+}
+
+void printOptions(const Options &options) {
+    const RenderConfig &config = options.config;
+
+    std::string saveLoc = options.save ? options.saveFileName.c_str() : "N/A";
+    std::cout << std::endl << std::string(options.load ? "Loading " : "Generating ") + std::string(config.anti ? "anti-" : "") + "buddhabrot with arguments :" << std::endl;
+    printf("\twindow size\t\t %d x %d\n", config.windowWidth, config.height());
+    printf("\tcentre\t\t\t %Lg, %Lg\n", config.centreReal, config.centreImag);
+    printf("\tzoom\t\t\t %Lg\n", config.zoom);
+    printf("\tseed domain\t\t (%Lg, %Lg) to (%Lg, %Lg)\n", config.seedMin.first, config.seedMin.second, config.seedMax.first, config.seedMax.second);
+    printf("\tseeds per row\t\t %s\n", config.halton ? "N/A" : std::to_string(config.seedColumns()).c_str());
+    printf("\tHalton sampling\t\t %s\n", config.halton ? "true" : "false");
+    if (config.halton) {
+        printf("\ttolerance\t\t %g\n", config.tolerance);
+        printf(config.timeLimit > 0 ? "\ttime limit\t\t %gs\n" : "\ttime limit\t\t N/A\n", config.timeLimit);
+    } else {
+        printf("\ttolerance\t\t N/A\n");
+        printf("\ttime limit\t\t N/A\n");
+    }
+    printf("\tcull seeds\t\t %s\n", config.cull && config.projections.empty() ? "true" : "false");
+    printf("\tinterior check\t\t %s\n", config.interiorCheck() ? "true" : "false");
+    printf("\tdetect cycles\t\t %s\n", config.cycles ? "true" : "false");
+    printf("\tuse symmetry\t\t %s\n", config.symmetric() ? "true" : "false");
+    printf("\tprojected views\t\t %s\n", config.projections.empty() ? "N/A" : std::to_string(config.projections.size()).c_str());
+    printf("\titerations\t\t %d\n", config.iterations);
+    printf("\tpower\t\t\t %Lg\n", config.power);
+    printf("\tgenerate with GPU\t %s\n", config.useGpu ? "true" : "false");
+    printf("\thybrid CPU + GPU\t %s\n", config.hybrid ? "true" : "false");
+    printf("\tOpenCL device\t\t %s\n", !config.usesOpenCL() ? "N/A" : config.device < 0 ? "first GPU" : std::to_string(config.device).c_str());
+    printf("\tOpenCL precision\t %s\n", config.usesOpenCL() ? precisionName(config.precision) : "N/A");
+    printf("\tthreads\t\t\t %s\n", config.useGpu && !config.hybrid ? "N/A" : std::to_string(config.numThreads).c_str());
+    printf("\tbucketed scatter\t %s\n", config.useGpu && !config.hybrid ? "N/A" : config.scatter ? "true" : "false");
+    printf("\tpin threads\t\t %s\n", config.usesOpenCL() ? "N/A" : config.pin ? "true" : "false");
+    printf("\tNUMA topology\t\t %s\n", config.usesOpenCL() ? "N/A" : Topology::detect().summary().c_str());
+    printf("\tcolour\t\t\t (%d, %d, %d)\n", config.colourR, config.colourG, config.colourB);
+    if (config.shardCount > 1) {
+        printf("\tshard\t\t\t %d/%d\n", config.shardIndex, config.shardCount);
+        printf("\tsave to\t\t\t %s.hist\n", saveLoc.c_str());
+    } else if (config.pyramid)
+        printf("\tsave to\t\t\t %s.dzi and %s.csv\n", saveLoc.c_str(), saveLoc.c_str());
+    else
+        printf("\tsave to\t\t\t %s.png and %s.csv\n", saveLoc.c_str(), saveLoc.c_str());
+    printf("\tpng depth\t\t %s\n", options.save ? (std::to_string(config.pngDepth) + " bits").c_str() : "N/A");
+    printf("\tpng with alpha\t\t %s\n", options.save ? config.alpha ? "true" : "false" : "N/A");
+    printf("\tmemory budget\t\t %s\n", config.maxMemory == 0 ? "N/A" : (std::to_string(config.maxMemory >> 20) + "MB").c_str());
+    printf("\tseed cache in\t\t %s\n", config.cacheDir.empty() ? "N/A" : config.cacheDir.c_str());
+    printf("\tstatistics to\t\t %s\n", options.stats ? options.statsFileName.c_str() : "N/A");
+
+    std::cout << std::endl;
+}
+
+void showUsage(std::string name) {
+    std::cerr << "Usage: " << name << " <option(s)>\n"
+        << "Options:\n"
+        << "\t-h\n\t\t Show this help message\n\n"
+        << "\t-a\n\t\t Generate an anti-buddhabrot\n\t\t defaults to false\n\n"
+        << "\t-o\n\t\t Calculate the buddhabrot using OpenCL, i.e using GPU\n\t\t defaults to false\n\n"
+        << "\t--hybrid\n\t\t Calculate the buddhabrot using both the CPU threads and OpenCL,\n\t\t each taking rows of seeds from one queue in chunks sized to its\n\t\t measured speed. Threads are not pinned\n\t\t defaults to false\n\n"
+        << "\t--device INDEX\n\t\t Use the OpenCL device at INDEX, counting every device of every\n\t\t platform in order, e.g a CPU runtime. Only used with -o or\n\t\t --hybrid\n\t\t defaults to the first GPU\n\n"
+        << "\t--precision auto|float|float-float|double\n\t\t Specify the precision of the OpenCL kernels. float-float pairs two\n\t\t floats for close to double precision on devices without fp64 or\n\t\t with slow fp64. Only used with -o or --hybrid\n\t\t defaults to auto, double if the device has fp64 and float-float\n\t\t otherwise\n\n"
+        << "\t-4\n\t\t Generate png with alpha based-brightness; viewer dependant\n\t\t defaults to false\n\n"
+#if USE_OPENGL
+        << "\t-s FILE_NAME\n\t\t Saves buddhabrot as a png and csv to the specified\n\t\t (FILE_NAME + '.png'/'.csv')\n\t\t defaults to not save\n\n"
+#else
+        << "\t-s FILE_NAME\n\t\t Saves buddhabrot as a png and csv to the specified\n\t\t (FILE_NAME + '.png'/'.csv')\n\t\t defaults to 'buddhabrot'\n\n"
+#endif
+        << "\t--png-depth BITS\n\t\t Save the png with 8 or 16 bits per channel. 16 bits keeps far more\n\t\t of the range of the counts\n\t\t defaults to 8\n\n"
+        << "\t--pyramid\n\t\t Save the png as a Deep Zoom pyramid instead, FILE_NAME + '.dzi' and\n\t\t 256 pixel tiles in FILE_NAME + '_files'. Each smaller level sums\n\t\t the counts of the one above before colouring them, so faint regions\n\t\t stay visible when zoomed out\n\t\t defaults to a single png\n\n"
+        << "\t-l FILE_NAME\n\t\t Loads buddhabrot from specified plaintext file. If correct -p\n\t\t not known, sqrt(lines in FILE_NAME - 1)\n\t\t defaults to not load\n\n"
+        << "\t-w WINDOW_WIDTH\n\t\t Specify the width and pixels of the window and buddhabrot\n\t\t defaults to 501\n\n"
+        << "\t--height WINDOW_HEIGHT\n\t\t Specify the height of the window and buddhabrot, along the real\n\t\t axis\n\t\t defaults to WINDOW_WIDTH\n\n"
+        << "\t--aspect RATIO\n\t\t Specify the height as WINDOW_WIDTH / RATIO instead\n\t\t defaults to 1\n\n"
+        << "\t--centre REAL,IMAG\n\t\t Specify the point of the complex plane at the centre of the window\n\t\t defaults to -0.75,0\n\n"
+        << "\t--zoom ZOOM\n\t\t Specify the magnification, at 1 the shorter side of the window\n\t\t spans 3.5\n\t\t defaults to 1\n\n"
+        << "\t--seed-domain MIN_REAL,MIN_IMAG,MAX_REAL,MAX_IMAG\n\t\t Specify the region that orbits are started from, independently of\n\t\t what is rendered\n\t\t defaults to -2.5,-1.75,1,1.75\n\n"
+        << "\t--seeds SEEDS_PER_ROW\n\t\t Specify the number of seeds along the imaginary axis of the seed\n\t\t domain, the spacing being the same along the real axis\n\t\t defaults to the larger of WINDOW_WIDTH and WINDOW_HEIGHT\n\n"
+        << "\t--halton\n\t\t Draw seeds from a scrambled Halton sequence over the seed domain,\n\t\t rather than the grid, in rounds of doubling size until the image\n\t\t stops changing. Not used with --shard\n\t\t defaults to the grid\n\n"
+        << "\t--tolerance FRACTION\n\t\t With --halton, stop once a round moves less than FRACTION of the\n\t\t image's brightness\n\t\t defaults to 0.01\n\n"
+        << "\t--time-limit SECONDS\n\t\t With --halton, also stop once SECONDS have passed\n\t\t defaults to no limit\n\n"
+        << "\t--no-cull\n\t\t Start orbits from every seed, rather than skipping the parts of the\n\t\t seed domain that a coarse pre-pass finds never reach the window.\n\t\t Culling only happens when the window is within the seed domain\n\t\t defaults to cull\n\n"
+        << "\t--no-interior\n\t\t Iterate every seed, rather than classifying the seeds inside of\n\t\t rectangles whose border stays bounded without iterating them.\n\t\t Only used for whole powers, and not for -a without -o\n\t\t defaults to classify them\n\n"
+        << "\t--no-cycles\n\t\t Iterate every orbit up to ITERATIONS, rather than stopping once it\n\t\t comes back around to a point it has already been through and\n\t\t binning the rest of its cycle in one go\n\t\t defaults to detect cycles\n\n"
+        << "\t--no-symmetry\n\t\t Evaluate the seeds on both sides of the real axis, rather than only\n\t\t evaluating one side and mirroring it. Symmetry is only used when\n\t\t both the window and seed domain are centred on the real axis\n\t\t defaults to use symmetry\n\n"
+        << "\t--projections PROJECTIONS_FILE\n\t\t Also bin every orbit into a view of its own per line of\n\t\t PROJECTIONS_FILE, each line being the 2x4 matrix, row by row, that\n\t\t takes the points (Re z, Im z, Re c, Im c) of the orbits to the\n\t\t window. The orbits are only evaluated once for every view, each\n\t\t saved as the -s FILE_NAME + '_viewNNN.png'. Seeds are not culled\n\t\t defaults to no views\n\n"
+        << "\t--rotate FRAMES\n\t\t Also bin every orbit into FRAMES views turning once around the\n\t\t (Re z, Re c) and (Im z, Im c) planes, as with --projections\n\t\t defaults to no views\n\n"
+        << "\t-i ITERATIONS\n\t\t Specify the number of iterations to be performed on each point\n\t\t defaults to 500\n\n"
+        << "\t--power DEGREE\n\t\t Generate the multibrot of z = z^DEGREE + c, for any DEGREE greater\n\t\t than 1. Whole degrees up to 8 are fastest. Other than 2, the\n\t\t centre defaults to 0,0 and the seed domain to -2,-2,2,2\n\t\t defaults to 2\n\n"
+        << "\t-m ITERATIONS_MAX\n\t\t Specify the number of iterations per group to be ran by the\n\t\t GPU. Important as prevents hanging GPU for larger ITERATIONS\n\t\t values. WINDOW_WIDTH is the largest influence of how large the\n\t\t ITERATION_MAX value can be. e.g 2001 can run at around 50000\n\t\t per group and 4501 at around 10000\n\t\t defaults to use estimation for maximum\n\n"
+        << "\t-c COLOUR_R,COLOUR_G,COLOUR_B\n\t\t Specify the render's colour\n\t\t defaults to 0,0,255\n\n"
+        << "\t-t NUM_THREADS\n\t\t Specify the number of threads to be used to compute the fractal\n\t\t defaults to the number of findable threads or 4\n\n"
+        << "\t--scatter\n\t\t Buffer each thread's increments per tile of the histogram, sized\n\t\t to stay in the L2 cache, and apply them a tile at a time. Faster\n\t\t once the histogram is much larger than the last level cache\n\t\t defaults to increment straight away\n\n"
+        << "\t--pin\n\t\t Pin each thread to a cpu, spreading them over the NUMA nodes. On\n\t\t machines with more than one node, each node's threads bin into\n\t\t their own copy of the histogram, which are summed at the end\n\t\t defaults to let threads move freely\n\n"
+        << "\t--shard INDEX/COUNT\n\t\t Only evaluate every COUNT-th band of 32 rows of seeds, starting\n\t\t from band INDEX, and save the partial histogram as FILE_NAME +\n\t\t '.hist' instead of a png and csv. Sum the shards with\n\t\t buddhabrot-merge\n\t\t defaults to 0/1, a whole render\n\n"
+        << "\t--max-memory MEGABYTES\n\t\t Keep the histogram and the GPU's buffers within about MEGABYTES.\n\t\t Larger histograms are backed by a temporary file and the GPU\n\t\t works through the image a band of rows at a time\n\t\t defaults to no limit\n\n"
+        << "\t--cache-dir DIRECTORY\n\t\t Keeps which seeds contribute in the existing DIRECTORY, so that\n\t\t later renders of the same seeds, iterations and anti, but any\n\t\t window or colour, skip checking them\n\t\t defaults to not cache\n\n"
+        << "\t--stats FILE_NAME\n\t\t Saves per-phase wall times and hot-path counters as JSON to the\n\t\t specified FILE_NAME. Iterations are only counted without -o\n\t\t defaults to not save\n\n"
+        << "\t--estimate\n\t\t Rather than rendering, evaluate a pilot of randomly drawn seeds and\n\t\t print the predicted calculation time, longest OpenCL kernel launch\n\t\t and peak host, disk and device memory of the render. Not used with\n\t\t --halton\n\t\t defaults to render\n\n"
+        << "\t--batch FILE_NAME\n\t\t Renders every job in FILE_NAME, one line of the above options per\n\t\t job. Jobs that only differ in colour, alpha, or where they are\n\t\t saved share one calculation. Lines starting with '#' are ignored\n\t\t defaults to a single render from the command line\n\n"
+        << "\t--serve SOCKET\n\t\t Stays running and renders requests sent over the UNIX domain socket\n\t\t SOCKET, keeping the OpenCL context, built kernels and recent\n\t\t renders warm in between. Use buddhabrot-client to send requests\n\t\t defaults to a single render from the command line\n"
+        << std::endl;
+}
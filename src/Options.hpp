@@ -0,0 +1,62 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "RenderConfig.hpp"
+
+#include <string>
+#include <vector>
+
+#ifndef Options_hpp
+#define Options_hpp
+
+// everything that can be given on the command line, or on a line of a batch file
+struct Options {
+    RenderConfig config;
+
+    bool load;
+    bool save;
+    bool stats;
+    bool batch;
+    bool serve;
+    bool estimate; // only estimate the render, rather than running it
+    bool threadsGiven;
+
+    double aspect; // width / height, only used when the height is not given
+
+    // multibrots default to a different centre and seed domain, unless they are given
+    bool centreGiven;
+    bool seedDomainGiven;
+
+    std::string loadFileName;
+    std::string saveFileName;
+    std::string statsFileName;
+    std::string batchFileName;
+    std::string serveSocketName;
+
+#if USE_OPENGL
+    Options() : load(false), save(false), stats(false), batch(false), serve(false), estimate(false), threadsGiven(false), aspect(0), centreGiven(false), seedDomainGiven(false) {};
+#else
+    Options() : load(false), save(true), stats(false), batch(false), serve(false), estimate(false), threadsGiven(false), aspect(0), centreGiven(false), seedDomainGiven(false), saveFileName("buddhabrot") {};
+#endif
+};
+
+// args do not include the program name. Returns 0 on success, -1 if the help message was asked for and 1 if any
+// option was not understood, in which case the rest of the options are still parsed
+int parseOptions(const std::vector<std::string> &args, Options *options);
+
+// whether two renders would calculate identical histograms, i.e only differ in colour, alpha, output or statistics
+bool sameHistogram(const Options &a, const Options &b);
+
+// splits a batch file line into arguments on whitespace, keeping anything inside double quotes together
+std::vector<std::string> splitArguments(const std::string &line);
+
+void printOptions(const Options &options);
+void showUsage(std::string name);
+
+#endif // Options_hpp
@@ -0,0 +1,366 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Orbit.hpp"
+
+#include "Scatter.hpp"
+#include "Views.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+// calls the version of function compiled for the degree of p, choosing once per orbit rather than per iteration
+#define DISPATCH_POWER(p, function, ...) \
+    switch ((p).integer) { \
+        case 2: return function<2>(__VA_ARGS__); \
+        case 3: return function<3>(__VA_ARGS__); \
+        case 4: return function<4>(__VA_ARGS__); \
+        case 5: return function<5>(__VA_ARGS__); \
+        case 6: return function<6>(__VA_ARGS__); \
+        case 7: return function<7>(__VA_ARGS__); \
+        case 8: return function<8>(__VA_ARGS__); \
+        default: return function<0>(__VA_ARGS__); \
+    }
+
+// how many machine epsilons apart two points of an orbit can be and still count as the same point of a cycle
+static const long double CYCLE_TOLERANCE_EPSILONS = 16;
+
+// Brent's cycle detection. Every point of an orbit is compared against the point saved at the last power of two
+// iterations, so a cycle of any period is found within a couple of its periods after the orbit settles into it
+struct CycleDetector {
+    ComplexNumber saved;
+    unsigned int power;
+    unsigned int period; // iterations since saved
+
+    CycleDetector() : saved(), power(1), period(1) {};
+
+    // whether z is back at the saved point, in which case period is the length of the cycle
+    inline bool found(const ComplexNumber &z, long double toleranceSquared) {
+        const ComplexNumber difference(z.real - saved.real, z.imag - saved.imag);
+        if (difference.norm() < toleranceSquared)
+            return true;
+
+        if (period == power) {
+            saved = z;
+            power *= 2;
+            period = 0;
+        }
+
+        ++period;
+        return false;
+    }
+};
+
+Power::Power(long double degree, bool cycles) : degree(degree) {
+    integer = degree == floorl(degree) && degree >= 2 && degree <= MAX_UNROLLED_POWER ? (unsigned int)degree : 0;
+
+    // |z| > max(2, 2^(1/(d-1))) means |z|^d - |z| > 2 >= |c|, so the orbit can only grow from there
+    long double bailout = std::max(2.0L, powl(2.0L, 1.0L / (degree - 1)));
+    bailoutSquared = bailout * bailout;
+
+    const long double tolerance = CYCLE_TOLERANCE_EPSILONS * std::numeric_limits<long double>::epsilon();
+    cycleToleranceSquared = cycles ? tolerance * tolerance : 0;
+}
+
+template <unsigned int P>
+inline ComplexNumber Orbit::step(const ComplexNumber &z, const ComplexNumber &c, const Power &) {
+    return power<P>(z) + c;
+}
+
+template <>
+inline ComplexNumber Orbit::step<0>(const ComplexNumber &z, const ComplexNumber &c, const Power &p) {
+    return z.pow(p.degree) + c;
+}
+
+template <unsigned int P, class Sink>
+bool Orbit::escape(const ComplexNumber &c, Sink *histogram, unsigned int iterations, const Power &p, bool anti, bool mirrored, std::vector<unsigned long int> *visited, ThreadCounters *counters) {
+    ComplexNumber z = ComplexNumber();
+    visited->clear();
+
+    CycleDetector cycle;
+    const bool cycles = p.cycleToleranceSquared > 0;
+
+    bool escaped = false;
+    bool settled = false;
+    unsigned int i = 0;
+
+    while (i < iterations) {
+        z = step<P>(z, c, p);
+        ++i;
+
+        unsigned long int index, mirror;
+        if (mirrored) {
+            if (histogram->index(z.real, z.imag, &index, &mirror)) {
+                visited->push_back(index);
+                visited->push_back(mirror);
+            }
+        } else if (histogram->index(z.real, z.imag, &index))
+            visited->push_back(index);
+
+        if (z.norm() > p.bailoutSquared) {
+            escaped = true;
+            break;
+        }
+
+        // a cycle never escapes, so the rest of the orbit is known without iterating it
+        if (cycles && cycle.found(z, p.cycleToleranceSquared)) {
+            settled = true;
+            counters->cyclesFound++;
+            break;
+        }
+    }
+
+    counters->orbitsEvaluated++;
+    counters->iterationsExecuted += i;
+
+    if (anti ? escaped : !escaped) // regular buddhabrot means that the point escapes
+        return false;
+
+    counters->contributingSeeds++;
+    counters->histogramIncrements += visited->size();
+
+    for (unsigned long int index : *visited)
+        histogram->increment(index);
+
+    if (settled)
+        counters->histogramIncrements += repeat<P>(z, c, histogram, iterations - i, cycle.period, p, mirrored, counters);
+
+    return true;
+}
+
+template <unsigned int P, class Sink>
+void Orbit::bin(const ComplexNumber &c, Sink *histogram, unsigned int iterations, const Power &p, bool mirrored, ThreadCounters *counters) {
+    ComplexNumber z = ComplexNumber();
+
+    CycleDetector cycle;
+    const bool cycles = p.cycleToleranceSquared > 0;
+
+    unsigned long int increments = 0;
+    unsigned int i = 0;
+
+    while (i < iterations) {
+        z = step<P>(z, c, p);
+        ++i;
+
+        unsigned long int index, mirror;
+        if (mirrored) {
+            if (histogram->index(z.real, z.imag, &index, &mirror)) {
+                histogram->increment(index);
+                histogram->increment(mirror);
+                increments += 2;
+            }
+        } else if (histogram->index(z.real, z.imag, &index)) {
+            histogram->increment(index);
+            ++increments;
+        }
+
+        if (z.norm() > p.bailoutSquared)
+            break;
+
+        if (cycles && cycle.found(z, p.cycleToleranceSquared)) {
+            counters->cyclesFound++;
+            increments += repeat<P>(z, c, histogram, iterations - i, cycle.period, p, mirrored, counters);
+            break;
+        }
+    }
+
+    counters->orbitsEvaluated++;
+    counters->iterationsExecuted += i;
+    counters->contributingSeeds++;
+    counters->histogramIncrements += increments;
+}
+
+template <unsigned int P, class Sink>
+unsigned long int Orbit::repeat(ComplexNumber z, const ComplexNumber &c, Sink *histogram, unsigned int remaining, unsigned int period, const Power &p, bool mirrored, ThreadCounters *counters) {
+    const unsigned int repetitions = remaining / period;
+    const unsigned int extra = remaining % period;
+
+    unsigned long int increments = 0;
+    unsigned int k = 0;
+
+    for (; k < period && k < remaining; ++k) {
+        z = step<P>(z, c, p);
+
+        // the first extra points of the cycle are also where the final, partial repetition goes
+        const unsigned int amount = repetitions + (k < extra ? 1 : 0);
+
+        unsigned long int index, mirror;
+        if (mirrored) {
+            if (histogram->index(z.real, z.imag, &index, &mirror)) {
+                histogram->add(index, amount);
+                histogram->add(mirror, amount);
+                increments += 2 * (unsigned long int)amount;
+            }
+        } else if (histogram->index(z.real, z.imag, &index)) {
+            histogram->add(index, amount);
+            increments += amount;
+        }
+    }
+
+    counters->iterationsExecuted += k;
+
+    return increments;
+}
+
+template <unsigned int P>
+bool Orbit::project(const ComplexNumber &c, Views *views, unsigned int iterations, const Power &p, bool anti, bool known, bool mirrored, ThreadCounters *counters) {
+    ComplexNumber z = ComplexNumber();
+
+    std::vector<ComplexNumber> *orbit = views->orbit();
+    orbit->clear();
+
+    CycleDetector cycle;
+    const bool cycles = p.cycleToleranceSquared > 0;
+
+    bool escaped = false;
+    bool settled = false;
+    unsigned long int increments = 0;
+    unsigned int i = 0;
+
+    while (i < iterations) {
+        z = step<P>(z, c, p);
+        ++i;
+
+        // a known orbit is binned as it goes, like in bin
+        if (known)
+            increments += views->bin(z, c, 1, mirrored);
+        else
+            orbit->push_back(z);
+
+        if (z.norm() > p.bailoutSquared) {
+            escaped = true;
+            break;
+        }
+
+        if (cycles && cycle.found(z, p.cycleToleranceSquared)) {
+            settled = true;
+            counters->cyclesFound++;
+            break;
+        }
+    }
+
+    counters->orbitsEvaluated++;
+    counters->iterationsExecuted += i;
+
+    if (!known && (anti ? escaped : !escaped))
+        return false;
+
+    counters->contributingSeeds++;
+
+    for (const ComplexNumber &point : *orbit)
+        increments += views->bin(point, c, 1, mirrored);
+
+    if (settled) {
+        const unsigned int remaining = iterations - i;
+        unsigned int k = 0;
+
+        for (; k < cycle.period && k < remaining; ++k) {
+            z = step<P>(z, c, p);
+            increments += views->bin(z, c, remaining / cycle.period + (k < remaining % cycle.period ? 1 : 0), mirrored);
+        }
+
+        counters->iterationsExecuted += k;
+    }
+
+    counters->histogramIncrements += increments;
+
+    return true;
+}
+
+template <unsigned int P>
+bool Orbit::touches(const ComplexNumber &c, const Histogram *histogram, unsigned int iterations, const Power &p, bool anti) {
+    ComplexNumber z = ComplexNumber();
+
+    CycleDetector cycle;
+    const bool cycles = p.cycleToleranceSquared > 0;
+
+    bool escaped = false;
+    bool inside = false;
+
+    for (unsigned int i = 0; i < iterations; ++i) {
+        z = step<P>(z, c, p);
+
+        unsigned long int index;
+        inside = inside || histogram->index(z.real, z.imag, &index);
+
+        if (z.norm() > p.bailoutSquared) {
+            escaped = true;
+            break;
+        }
+
+        // the rest of the orbit only goes around the cycle, so one more time around covers everywhere it goes
+        if (cycles && cycle.found(z, p.cycleToleranceSquared)) {
+            for (unsigned int k = 0; anti && !inside && k < cycle.period && i + 1 + k < iterations; ++k) {
+                z = step<P>(z, c, p);
+                inside = histogram->index(z.real, z.imag, &index);
+            }
+
+            break;
+        }
+    }
+
+    return inside && (anti ? !escaped : escaped);
+}
+
+template <unsigned int P>
+bool Orbit::escapes(const ComplexNumber &c, unsigned int iterations, const Power &p) {
+    ComplexNumber z = ComplexNumber();
+
+    CycleDetector cycle;
+    const bool cycles = p.cycleToleranceSquared > 0;
+
+    for (unsigned int i = 0; i < iterations; ++i) {
+        z = step<P>(z, c, p);
+
+        if (z.norm() > p.bailoutSquared)
+            return true;
+
+        if (cycles && cycle.found(z, p.cycleToleranceSquared))
+            return false;
+    }
+
+    return false;
+}
+
+bool Orbit::escape(const ComplexNumber &c, Histogram *histogram, unsigned int iterations, const Power &p, bool anti, bool mirrored, std::vector<unsigned long int> *visited, ThreadCounters *counters) {
+    DISPATCH_POWER(p, escape, c, histogram, iterations, p, anti, mirrored, visited, counters);
+}
+
+bool Orbit::escape(const ComplexNumber &c, Scatter *scatter, unsigned int iterations, const Power &p, bool anti, bool mirrored, std::vector<unsigned long int> *visited, ThreadCounters *counters) {
+    DISPATCH_POWER(p, escape, c, scatter, iterations, p, anti, mirrored, visited, counters);
+}
+
+bool Orbit::escape(const ComplexNumber &c, Views *views, unsigned int iterations, const Power &p, bool anti, bool mirrored, std::vector<unsigned long int> *, ThreadCounters *counters) {
+    return project(c, views, iterations, p, anti, false, mirrored, counters);
+}
+
+void Orbit::bin(const ComplexNumber &c, Histogram *histogram, unsigned int iterations, const Power &p, bool mirrored, ThreadCounters *counters) {
+    DISPATCH_POWER(p, bin, c, histogram, iterations, p, mirrored, counters);
+}
+
+void Orbit::bin(const ComplexNumber &c, Scatter *scatter, unsigned int iterations, const Power &p, bool mirrored, ThreadCounters *counters) {
+    DISPATCH_POWER(p, bin, c, scatter, iterations, p, mirrored, counters);
+}
+
+void Orbit::bin(const ComplexNumber &c, Views *views, unsigned int iterations, const Power &p, bool mirrored, ThreadCounters *counters) {
+    project(c, views, iterations, p, false, true, mirrored, counters);
+}
+
+bool Orbit::project(const ComplexNumber &c, Views *views, unsigned int iterations, const Power &p, bool anti, bool known, bool mirrored, ThreadCounters *counters) {
+    DISPATCH_POWER(p, project, c, views, iterations, p, anti, known, mirrored, counters);
+}
+
+bool Orbit::touches(const ComplexNumber &c, const Histogram *histogram, unsigned int iterations, const Power &p, bool anti) {
+    DISPATCH_POWER(p, touches, c, histogram, iterations, p, anti);
+}
+
+bool Orbit::escapes(const ComplexNumber &c, unsigned int iterations, const Power &p) {
+    DISPATCH_POWER(p, escapes, c, iterations, p);
+}
@@ -0,0 +1,103 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "ComplexNumber.hpp"
+#include "Histogram.hpp"
+#include "Statistics.hpp"
+
+#include <vector>
+
+#ifndef Orbit_hpp
+#define Orbit_hpp
+
+class Scatter;
+class Views;
+
+// whole degrees up to this are unrolled into chains of multiplications, anything else goes through the polar form
+static const unsigned int MAX_UNROLLED_POWER = 8;
+
+// the degree d of z = z^d + c, d = 2 being the regular buddhabrot
+struct Power {
+    long double degree;
+    unsigned int integer; // degree, if it is a whole number up to MAX_UNROLLED_POWER, otherwise 0
+
+    // once |z| passes the bailout, |z^d + c| keeps growing for every c in the seed domain
+    long double bailoutSquared;
+
+    // an orbit that comes back to within this of a point it has already been through has settled into a cycle, a
+    // few rounding errors of the long doubles it is iterated in. 0 when cycles are not looked for
+    long double cycleToleranceSquared;
+
+    Power(long double degree, bool cycles);
+};
+
+// z^P, as a chain of squarings and multiplications worked out at compile time
+template <unsigned int P>
+inline ComplexNumber power(const ComplexNumber &z) {
+    return P % 2 == 0 ? power<P / 2>(z).square() : power<P - 1>(z) * z;
+}
+
+template <>
+inline ComplexNumber power<1>(const ComplexNumber &z) {
+    return z;
+}
+
+// CPU implementation of iterating z = z^d + c from z = 0 for a single seed c
+class Orbit {
+private:
+    template <unsigned int P>
+    static inline ComplexNumber step(const ComplexNumber &z, const ComplexNumber &c, const Power &p);
+
+    // Sink is either the Histogram itself or a Scatter buffering increments into it
+    template <unsigned int P, class Sink>
+    static bool escape(const ComplexNumber &c, Sink *histogram, unsigned int iterations, const Power &p, bool anti, bool mirrored, std::vector<unsigned long int> *visited, ThreadCounters *counters);
+
+    template <unsigned int P, class Sink>
+    static void bin(const ComplexNumber &c, Sink *histogram, unsigned int iterations, const Power &p, bool mirrored, ThreadCounters *counters);
+
+    // bins the remaining iterations of an orbit that has settled into a cycle of period points after z, adding
+    // each point of the cycle once per repetition left rather than iterating through every repetition
+    template <unsigned int P, class Sink>
+    static unsigned long int repeat(ComplexNumber z, const ComplexNumber &c, Sink *histogram, unsigned int remaining, unsigned int period, const Power &p, bool mirrored, ThreadCounters *counters);
+
+    // escape and bin for views, known being whether c is already known to contribute
+    template <unsigned int P>
+    static bool project(const ComplexNumber &c, Views *views, unsigned int iterations, const Power &p, bool anti, bool known, bool mirrored, ThreadCounters *counters);
+
+    static bool project(const ComplexNumber &c, Views *views, unsigned int iterations, const Power &p, bool anti, bool known, bool mirrored, ThreadCounters *counters);
+
+    template <unsigned int P>
+    static bool touches(const ComplexNumber &c, const Histogram *histogram, unsigned int iterations, const Power &p, bool anti);
+
+    template <unsigned int P>
+    static bool escapes(const ComplexNumber &c, unsigned int iterations, const Power &p);
+
+public:
+    // bins the orbit of c into the histogram if it contributes, i.e escapes for a regular buddhabrot or stays
+    // bounded for an anti-buddhabrot. mirrored also bins the orbit of c's conjugate, which is the conjugate of
+    // the orbit. visited is scratch space, kept by the caller so it is not reallocated per orbit
+    static bool escape(const ComplexNumber &c, Histogram *histogram, unsigned int iterations, const Power &p, bool anti, bool mirrored, std::vector<unsigned long int> *visited, ThreadCounters *counters);
+    static bool escape(const ComplexNumber &c, Scatter *scatter, unsigned int iterations, const Power &p, bool anti, bool mirrored, std::vector<unsigned long int> *visited, ThreadCounters *counters);
+
+    // as above for every view at once, the views holding on to the orbit themselves so visited is left unused
+    static bool escape(const ComplexNumber &c, Views *views, unsigned int iterations, const Power &p, bool anti, bool mirrored, std::vector<unsigned long int> *visited, ThreadCounters *counters);
+
+    // bins the orbit of a seed already known to contribute as it goes, with no need to hold on to the orbit
+    static void bin(const ComplexNumber &c, Histogram *histogram, unsigned int iterations, const Power &p, bool mirrored, ThreadCounters *counters);
+    static void bin(const ComplexNumber &c, Scatter *scatter, unsigned int iterations, const Power &p, bool mirrored, ThreadCounters *counters);
+    static void bin(const ComplexNumber &c, Views *views, unsigned int iterations, const Power &p, bool mirrored, ThreadCounters *counters);
+
+    // whether the orbit of c contributes and has any point inside of the histogram's viewport, without binning it
+    static bool touches(const ComplexNumber &c, const Histogram *histogram, unsigned int iterations, const Power &p, bool anti);
+
+    // whether the orbit of c passes the bailout within iterations, without looking at where it goes
+    static bool escapes(const ComplexNumber &c, unsigned int iterations, const Power &p);
+};
+
+#endif // Orbit_hpp
@@ -0,0 +1,85 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Projection.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <math.h>
+#include <sstream>
+
+bool Projection::operator==(const Projection &other) const {
+    return std::equal(&matrix[0][0], &matrix[0][0] + 8, &other.matrix[0][0]);
+}
+
+Projection Projection::identity() {
+    return rotation(0);
+}
+
+Projection Projection::rotation(long double angle) {
+    const long double cosine = cosl(angle);
+    const long double sine = sinl(angle);
+
+    Projection projection = { {
+        { cosine, 0, sine, 0 },
+        { 0, cosine, 0, sine }
+    } };
+
+    return projection;
+}
+
+std::vector<Projection> rotationFrames(unsigned int frames) {
+    std::vector<Projection> projections;
+
+    for (unsigned int i = 0; i < frames; ++i)
+        projections.push_back(Projection::rotation(2 * M_PI * i / frames));
+
+    return projections;
+}
+
+int readProjections(const std::string &fileName, std::vector<Projection> *projections) {
+    std::ifstream file(fileName);
+    if (!file.is_open()) {
+        std::cout << "Failed to open projections file " << fileName << std::endl;
+        return 1;
+    }
+
+    std::string line;
+    unsigned int lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        ++lineNumber;
+
+        std::replace(line.begin(), line.end(), ',', ' ');
+
+        const size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        std::stringstream lineStream(line);
+        Projection projection;
+
+        long double *entry = &projection.matrix[0][0];
+        unsigned int count = 0;
+
+        while (count < 8 && lineStream >> entry[count])
+            ++count;
+
+        std::string rest;
+        if (count != 8 || lineStream >> rest) {
+            std::cout << "Line " << lineNumber << " of " << fileName << " is not 8 numbers" << std::endl;
+            return 1;
+        }
+
+        projections->push_back(projection);
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "ComplexNumber.hpp"
+
+#include <string>
+#include <vector>
+
+#ifndef Projection_hpp
+#define Projection_hpp
+
+// a view of the orbits in 4D, as a 2x4 matrix taking each point z of the orbit of c, i.e (Re z, Im z, Re c, Im c),
+// to the (real, imag) that it is binned at in the viewport. The regular buddhabrot is the identity, which takes
+// the point to z itself
+struct Projection {
+    long double matrix[2][4];
+
+    inline void apply(const ComplexNumber &z, const ComplexNumber &c, long double *real, long double *imag) const {
+        *real = matrix[0][0] * z.real + matrix[0][1] * z.imag + matrix[0][2] * c.real + matrix[0][3] * c.imag;
+        *imag = matrix[1][0] * z.real + matrix[1][1] * z.imag + matrix[1][2] * c.real + matrix[1][3] * c.imag;
+    };
+
+    // whether the real parts only go to the real axis and the imaginary parts to the imaginary axis, so that
+    // conjugate orbits land on mirror images of each other like they do in the regular buddhabrot
+    bool separable() const { return matrix[0][1] == 0 && matrix[0][3] == 0 && matrix[1][0] == 0 && matrix[1][2] == 0; };
+
+    bool operator==(const Projection &other) const;
+
+    static Projection identity();
+
+    // turned by angle in both the (Re z, Re c) and (Im z, Im c) planes at once, from the buddhabrot at 0 through the
+    // seeds themselves at pi/2 to the buddhabrot flipped over at pi
+    static Projection rotation(long double angle);
+};
+
+// frames rotations evenly spread over a whole turn, as in Projection::rotation
+std::vector<Projection> rotationFrames(unsigned int frames);
+
+// reads one projection per line of fileName, as the 8 numbers of its matrix row by row separated by whitespace or
+// commas. Blank lines and lines starting with '#' are ignored. Returns 0 on success, 1 if the file could not be
+// read or a line is not a matrix
+int readProjections(const std::string &fileName, std::vector<Projection> *projections);
+
+#endif // Projection_hpp
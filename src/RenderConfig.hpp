@@ -0,0 +1,140 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Projection.hpp"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef RenderConfig_hpp
+#define RenderConfig_hpp
+
+// extent of the full buddhabrot, used both as the default viewport and as the default seed domain
+static const long double REAL_DIFF = 3.5;
+static const std::pair<long double, long double> MIN = { -2.5, -1.75 };
+static const std::pair<long double, long double> MAX = { MIN.first + REAL_DIFF, MIN.second + REAL_DIFF };
+
+// precision of the OpenCL kernels. Automatic uses double where the device has fp64, and float-float otherwise
+enum KernelPrecision {
+    PRECISION_AUTO,
+    PRECISION_FLOAT,
+    PRECISION_FLOAT_FLOAT,
+    PRECISION_DOUBLE
+};
+
+// as given to --precision
+inline const char *precisionName(KernelPrecision precision) {
+    switch (precision) {
+        case PRECISION_FLOAT: return "float";
+        case PRECISION_FLOAT_FLOAT: return "float-float";
+        case PRECISION_DOUBLE: return "double";
+        default: return "auto";
+    }
+}
+
+struct RenderConfig {
+    unsigned int iterations;
+    unsigned int iterationsMax; // 0 uses the estimation in calculateCells
+    unsigned int windowWidth;
+    unsigned int windowHeight; // 0 for a square window
+    unsigned int numThreads;
+
+    unsigned char colourR;
+    unsigned char colourG;
+    unsigned char colourB;
+
+    bool anti;
+    bool alpha;
+    unsigned int pngDepth; // bits per channel of the png, 8 or 16
+    bool pyramid;          // save the png as a deep zoom pyramid of tiles instead
+    bool useGpu;
+    bool hybrid; // the CPU threads and the OpenCL device working through the seeds together
+
+    // which OpenCL device to use out of every device of every platform, -1 for the first GPU, and in what precision
+    int device;
+    KernelPrecision precision;
+
+    // degree d of z = z^d + c, greater than 1
+    long double power;
+
+    // viewport, i.e what the histogram covers. At a zoom of 1 the shorter side of the window spans REAL_DIFF
+    long double centreReal;
+    long double centreImag;
+    long double zoom;
+
+    // seed domain, i.e where the orbits start from, sampled on a grid of seedsPerRow seeds along the imaginary axis
+    std::pair<long double, long double> seedMin;
+    std::pair<long double, long double> seedMax;
+    unsigned int seedsPerRow; // 0 for one seed per pixel along the longer side of the window
+
+    // draw the seeds from a scrambled Halton sequence over the seed domain rather than the grid, in rounds of
+    // doubling size, until the histogram moves by less than tolerance of its brightness in a round, or timeLimit
+    // seconds have passed if it is not 0
+    bool halton;
+    double tolerance;
+    double timeLimit;
+
+    // only sample the seed tiles found to send orbits into the viewport, when the viewport is smaller than the seed domain
+    bool cull;
+
+    // classify the seeds inside of bounded rectangles without iterating them, when the render allows it
+    bool interior;
+
+    // stop iterating orbits that have settled into a cycle, binning the cycle once per repetition left instead
+    bool cycles;
+
+    // further views of the orbits in 4D, each binned into a histogram of its own alongside the viewport's
+    std::vector<Projection> projections;
+
+    // only evaluate the seeds on one side of the real axis and mirror their orbits, when the render allows it
+    bool symmetry;
+
+    // this process only evaluates the bands of INTERIOR_BLOCK_SIZE seed rows with band % shardCount == shardIndex,
+    // and saves a partial histogram
+    unsigned int shardIndex;
+    unsigned int shardCount;
+
+    // buffer each CPU worker's increments per L2 sized tile of the histogram, rather than scattering them all over it
+    bool scatter;
+
+    // pin the CPU workers to cpus spread over the NUMA nodes, each node binning into its own copy of the histogram
+    bool pin;
+
+    // bytes that the histogram and the GPU's buffers should stay within, 0 for no limit other than the GPU's own
+    unsigned long long maxMemory;
+
+    // directory to keep which seeds contribute in between runs, empty to not keep them
+    std::string cacheDir;
+
+    RenderConfig() : iterations(500), iterationsMax(0), windowWidth(501), windowHeight(0), numThreads(std::thread::hardware_concurrency() != 0 ? std::thread::hardware_concurrency() : 4), colourR(0), colourG(0), colourB(255), anti(false), alpha(false), pngDepth(8), pyramid(false), useGpu(false), hybrid(false), device(-1), precision(PRECISION_AUTO), power(2), centreReal(MIN.first + REAL_DIFF / 2), centreImag(MIN.second + REAL_DIFF / 2), zoom(1.0), seedMin(MIN), seedMax(MAX), seedsPerRow(0), halton(false), tolerance(0.01), timeLimit(0), cull(true), interior(true), cycles(true), symmetry(true), shardIndex(0), shardCount(1), scatter(false), pin(false), maxMemory(0) {};
+
+    unsigned int height() const { return windowHeight != 0 ? windowHeight : windowWidth; };
+    unsigned int seedColumns() const { return seedsPerRow != 0 ? seedsPerRow : std::max(windowWidth, height()); };
+
+    long double cellWidth() const { return REAL_DIFF / (zoom * std::min(windowWidth, height())); };
+    long double viewportMinReal() const { return centreReal - cellWidth() * height() / 2; };
+    long double viewportMinImag() const { return centreImag - cellWidth() * windowWidth / 2; };
+
+    // the seeds that stay bounded only form regions without holes for polynomials, i.e whole degrees. On the CPU,
+    // an anti-buddhabrot has to iterate every bounded seed to bin it anyway, so gains nothing from knowing them early.
+    // The interior check classifies the seeds of the grid, so is not used when the seeds come from the Halton
+    // sequence
+    bool interiorCheck() const { return interior && !halton && power == (long double)(long long)power && (usesOpenCL() || !anti); };
+
+    bool usesOpenCL() const { return useGpu || hybrid; };
+
+    // the conjugate of every orbit is also an orbit, so both the viewport and the seed domain have to be symmetric
+    // about the real axis for one half of the seeds to stand in for the other. Fractional powers are left out, as
+    // their branch cut along the negative real axis breaks the symmetry
+    bool symmetric() const { return symmetry && centreImag == 0 && seedMin.second == -seedMax.second && power == (long double)(long long)power; };
+};
+
+#endif // RenderConfig_hpp
@@ -0,0 +1,324 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "RenderServer.hpp"
+
+#include "io/HistogramFile.hpp"
+#include "io/PNGWriter.hpp"
+
+#ifndef _WIN32
+    #include <signal.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+std::shared_ptr<RenderServer::Job> RenderServer::acquire(const Options &options) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    std::shared_ptr<Job> job;
+
+    // the lanes may already have finished, so nothing new is queued
+    if (stopping) {
+        job = std::make_shared<Job>(options);
+        job->finished = true;
+        job->err = 1;
+
+        return job;
+    }
+
+    for (std::list<std::shared_ptr<Job>>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        if (sameHistogram((*it)->options, options)) {
+            job = *it;
+            jobs.erase(it);
+            break;
+        }
+    }
+
+    if (!job) {
+        job = std::make_shared<Job>(options);
+
+        (options.config.useGpu ? gpuQueue : cpuQueue).push_back(job);
+        queued.notify_all();
+    }
+
+    jobs.push_front(job);
+
+    // forget the least recently used renders past the limit, leaving any that are still to be rendered
+    unsigned int kept = 0;
+
+    for (std::list<std::shared_ptr<Job>>::iterator it = jobs.begin(); it != jobs.end();) {
+        if ((*it)->finished && ++kept > SERVER_CACHED_RENDERS)
+            it = jobs.erase(it);
+        else
+            ++it;
+    }
+
+    finished.wait(lock, [&job]() { return job->finished; });
+
+    return job;
+}
+
+void RenderServer::runLane(std::deque<std::shared_ptr<Job>> *queue) {
+    for (;;) {
+        std::shared_ptr<Job> job;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued.wait(lock, [this, queue]() { return stopping || !queue->empty(); });
+
+            // anything still queued is failed once both lanes have finished
+            if (stopping)
+                return;
+
+            job = queue->front();
+            queue->pop_front();
+        }
+
+        std::shared_ptr<Renderer> renderer = std::make_shared<Renderer>(job->options.config);
+
+        int err = job->options.load ? renderer->load(job->options.loadFileName) : renderer->render();
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        job->renderer = err == 0 ? renderer : std::shared_ptr<Renderer>();
+        job->err = err;
+        job->finished = true;
+
+        // a failed render is not worth keeping, so that asking again tries again
+        if (err != 0)
+            jobs.remove(job);
+
+        finished.notify_all();
+    }
+}
+
+std::string RenderServer::handle(const std::string &request) {
+    std::vector<std::string> args = splitArguments(request);
+
+    if (args.empty())
+        return "ERROR empty request\n";
+
+    const std::string format = args[0];
+    args.erase(args.begin());
+
+    if (format != "png" && format != "hist")
+        return "ERROR unknown format " + format + ", expected png or hist\n";
+
+    Options options;
+    if (parseOptions(args, &options) != 0 || options.batch || options.serve || options.estimate)
+        return "ERROR invalid options\n";
+
+    double start = Statistics::now();
+
+    std::shared_ptr<Job> job = acquire(options);
+    if (job->err != 0)
+        return "ERROR render failed\n";
+
+    const Renderer &renderer = *job->renderer;
+    const RenderConfig &config = options.config;
+
+    std::ostringstream output;
+    int err;
+
+    if (format == "png") {
+        // only the colours of this request, the histogram can be shared with any number of others
+        PNGWriter picture("", config.colourR, config.colourG, config.colourB, renderer.getMaxCount(), config.alpha, config.pngDepth, std::max(config.numThreads, 1u));
+        err = picture.write(&renderer.getHistogram(), &output);
+    } else
+        err = HistogramFile::write(&renderer.getHistogram(), renderer.getConfig(), &output);
+
+    if (err != 0)
+        return "ERROR failed to encode " + format + "\n";
+
+    std::cout << "Served " << format << " of " << request.substr(request.find(' ') == std::string::npos ? request.size() : request.find(' ') + 1) << " in " << (Statistics::now() - start) * 1000.0 << "ms" << std::endl;
+
+    const std::string body = output.str();
+
+    return "OK " + std::to_string(body.size()) + "\n" + body;
+}
+
+#ifndef _WIN32
+
+void RenderServer::serveConnection(int socket) {
+    std::string buffer;
+    char received[4096];
+
+    for (;;) {
+        size_t newline = buffer.find('\n');
+
+        if (newline == std::string::npos) {
+            ssize_t length = recv(socket, received, sizeof(received), 0);
+            if (length <= 0)
+                break;
+
+            buffer.append(received, length);
+            continue;
+        }
+
+        std::string request = buffer.substr(0, newline);
+        buffer.erase(0, newline + 1);
+
+        if (!request.empty() && request.back() == '\r')
+            request.pop_back();
+
+        std::string response;
+
+        if (request == "shutdown") {
+            response = "OK 0\n";
+            stop();
+        } else
+            response = handle(request);
+
+        for (size_t sent = 0; sent < response.size();) {
+            ssize_t length = send(socket, response.data() + sent, response.size() - sent, 0);
+            if (length <= 0)
+                break;
+
+            sent += length;
+        }
+    }
+
+    close(socket);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    connectionSockets.erase(std::remove(connectionSockets.begin(), connectionSockets.end(), socket), connectionSockets.end());
+    connectionClosed.notify_all();
+}
+
+void RenderServer::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    stopping = true;
+    queued.notify_all();
+
+    // wakes up accept, and any connections waiting on their clients
+    shutdown(listener, SHUT_RDWR);
+
+    for (int socket : connectionSockets)
+        shutdown(socket, SHUT_RD);
+}
+
+int RenderServer::run() {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (socketName.size() >= sizeof(address.sun_path)) {
+        std::cout << "Socket path " << socketName << " is too long" << std::endl;
+        return 1;
+    }
+
+    strncpy(address.sun_path, socketName.c_str(), sizeof(address.sun_path) - 1);
+
+    // a socket left behind by a previous server is replaced, anything else at the path is left alone
+    struct stat existing;
+    if (lstat(socketName.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cout << socketName << " already exists and is not a socket" << std::endl;
+            return 1;
+        }
+
+        unlink(socketName.c_str());
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        std::cout << "Failed to listen on " << socketName << ": " << strerror(errno) << std::endl;
+
+        if (listener >= 0)
+            close(listener);
+        return 1;
+    }
+
+    // clients that hang up early must not take the server down with them
+    signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "Serving renders on " << socketName << std::endl;
+
+    std::thread cpuLane(&RenderServer::runLane, this, &cpuQueue);
+    std::thread gpuLane(&RenderServer::runLane, this, &gpuQueue);
+
+    for (;;) {
+        int connection = accept(listener, NULL, NULL);
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (stopping) {
+            if (connection >= 0)
+                close(connection);
+            break;
+        }
+
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            std::cout << "Failed to accept a connection: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        // connections are detached, so a long running server does not collect one finished thread per connection
+        connectionSockets.push_back(connection);
+        std::thread(&RenderServer::serveConnection, this, connection).detach();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queued.notify_all();
+    }
+
+    cpuLane.join();
+    gpuLane.join();
+
+    // connections waiting on a render that will not happen any more give up on it, and are then waited on
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        for (std::shared_ptr<Job> &job : jobs) {
+            if (!job->finished) {
+                job->finished = true;
+                job->err = 1;
+            }
+        }
+
+        finished.notify_all();
+
+        for (int socket : connectionSockets)
+            shutdown(socket, SHUT_RD);
+
+        connectionClosed.wait(lock, [this]() { return connectionSockets.empty(); });
+    }
+
+    close(listener);
+    unlink(socketName.c_str());
+
+    std::cout << "Stopped serving renders" << std::endl;
+
+    return 0;
+}
+
+#else
+
+int RenderServer::run() {
+    std::cout << "Serving renders needs UNIX domain sockets, which are not supported on this platform" << std::endl;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,82 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Options.hpp"
+#include "Renderer.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef RenderServer_hpp
+#define RenderServer_hpp
+
+// finished renders kept around for requests that only differ in how they are drawn
+static const unsigned int SERVER_CACHED_RENDERS = 8;
+
+// renders requests sent over a UNIX domain socket, staying up between them so that the OpenCL context, built
+// programs and recent histograms stay warm. Each request is a line of
+//
+//     FORMAT OPTIONS...
+//
+// where FORMAT is png or hist and OPTIONS are the same as on the command line, answered with "OK LENGTH\n" and
+// LENGTH bytes of the png or the binary histogram, or "ERROR MESSAGE\n". A connection can send any number of
+// requests, one after another, and a line of "shutdown" stops the server. OpenCL and CPU renders are queued
+// separately, each running one at a time on its own lane, and requests for a histogram that is already queued,
+// rendering or cached wait on that one rather than calculating it again
+class RenderServer {
+private:
+    struct Job {
+        Options options;
+        std::shared_ptr<Renderer> renderer; // set once rendered
+
+        bool finished;
+        int err;
+
+        Job(const Options &options) : options(options), finished(false), err(0) {};
+    };
+
+    std::string socketName;
+    int listener;
+
+    // every job queued, rendering or finished, most recently used first. Only finished jobs are ever dropped
+    std::list<std::shared_ptr<Job>> jobs;
+    std::deque<std::shared_ptr<Job>> cpuQueue;
+    std::deque<std::shared_ptr<Job>> gpuQueue;
+
+    std::vector<int> connectionSockets;
+
+    bool stopping;
+
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable finished;
+    std::condition_variable connectionClosed;
+
+    std::shared_ptr<Job> acquire(const Options &options);
+    void runLane(std::deque<std::shared_ptr<Job>> *queue);
+
+    void serveConnection(int socket);
+    std::string handle(const std::string &request);
+    void stop();
+
+public:
+    RenderServer(const std::string &socketName) : socketName(socketName), listener(-1), stopping(false) {};
+
+    RenderServer(const RenderServer&) = delete;
+    RenderServer &operator=(const RenderServer&) = delete;
+
+    int run();
+};
+
+#endif // RenderServer_hpp
@@ -0,0 +1,688 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Renderer.hpp"
+
+#include "Orbit.hpp"
+#include "Scatter.hpp"
+
+#include "io/CSVReader.hpp"
+#include "io/HistogramFile.hpp"
+#include "io/PNGWriter.hpp"
+#include "io/PyramidWriter.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <math.h>
+#include <thread>
+
+// seeds drawn by the first round of Halton sampling, every round after that drawing as many as all before it
+static const uint64_t SAMPLES_FIRST_ROUND = 1 << 14;
+
+// seeds drawn for the OpenCL device at a time, bounding the memory of the seeds of a large round
+static const uint64_t SAMPLES_PER_DISPATCH = 1 << 22;
+
+// half of the sum of the differences between the histogram and previous, each normalised to add up to 1, i.e
+// the fraction of the image's brightness that has moved since previous. previous is left holding the histogram
+static double histogramChange(const Histogram &histogram, std::vector<unsigned int> *previous) {
+    unsigned long long total = 0, previousTotal = 0;
+
+    for (unsigned long int i = 0; i < histogram.size(); ++i) {
+        total += histogram.get(i);
+        previousTotal += (*previous)[i];
+    }
+
+    double change = 0;
+
+    for (unsigned long int i = 0; i < histogram.size(); ++i) {
+        const unsigned int count = histogram.get(i);
+
+        if (total != 0 && previousTotal != 0)
+            change += fabs((double)count / total - (double)(*previous)[i] / previousTotal);
+
+        (*previous)[i] = count;
+    }
+
+    return total != 0 && previousTotal != 0 ? change / 2 : 1;
+}
+
+Renderer::~Renderer() {
+    release();
+}
+
+void Renderer::release() {
+    histogram.release();
+    projected.clear();
+
+    maxCount = 0;
+}
+
+void Renderer::allocateHistogram() {
+    // the views of any projections share the memory budget with the viewport
+    const unsigned long long memory = config.maxMemory / (config.projections.size() + 1);
+
+    histogram.allocate(config.windowWidth, config.height(), config.viewportMinReal(), config.viewportMinImag(), config.cellWidth(), memory);
+}
+
+int Renderer::render() {
+    release();
+    stats = Statistics();
+
+    double allocationStart = Statistics::now();
+
+    allocateHistogram();
+
+    projected = std::vector<Histogram>(config.projections.size());
+    for (Histogram &view : projected)
+        view.allocate(histogram.width, histogram.height, histogram.minReal, histogram.minImag, histogram.cellWidth, config.maxMemory / (projected.size() + 1));
+
+    SeedGrid grid(config);
+
+    stats.addPhase("allocation", Statistics::now() - allocationStart);
+
+    // seeds far outside of a zoomed in viewport almost never send orbits into it, so only the tiles that do are kept
+    if (grid.cullable(&histogram, config)) {
+        double cullStart = Statistics::now();
+
+        grid.cull(&histogram, config);
+
+        stats.addPhase("cull", Statistics::now() - cullStart);
+
+        std::cout << "Seeds kept after culling := " << grid.activeCount() << '/' << grid.count() << std::endl;
+    }
+
+    if (grid.symmetric && !config.halton)
+        std::cout << "Seeds evaluated using symmetry := " << grid.evaluatedCount() << '/' << grid.count() << std::endl;
+
+    SeedCache *cache = NULL;
+
+    // the cache knows about seeds of the grid, which the Halton sequence never draws
+    if (!config.cacheDir.empty() && !config.halton) {
+        double cacheStart = Statistics::now();
+
+        cache = new SeedCache(config.cacheDir, config, grid, config.usesOpenCL() ? OpenCLKernelHelper::precisionBits(helper->resolvePrecision(config.precision)) : sizeof(long double) * 8);
+        if (cache->load() != 0)
+            std::cout << "No seed cache found, starting " << cache->getFileName() << std::endl;
+
+        stats.addPhase("cache", Statistics::now() - cacheStart);
+    }
+
+    // seeds inside of the set are the most expensive to iterate, and are found from the borders of the regions
+    // that they fill. Not worth it once the cache knows about as many seeds as are evaluated
+    if (config.interiorCheck() && !(cache && cache->loadedCount() >= grid.evaluatedCount())) {
+        double interiorStart = Statistics::now();
+
+        unsigned long int iterated;
+        unsigned long int classified = grid.classifyInterior(config, &iterated);
+
+        stats.addPhase("interior", Statistics::now() - interiorStart);
+
+        std::cout << "Seeds classified by the interior check := " << classified << '/' << grid.count() << ", " << iterated << " of them iterated" << std::endl;
+    }
+
+    if (config.halton) {
+        if (executeSampled(&grid) != 0)
+            return 1;
+    } else if (config.hybrid) {
+        executeHybrid(&grid, cache);
+    } else if (config.useGpu) {
+        if (helper->calculateCells(&histogram, &projected, config, grid, cache, &stats) != 0) {
+            delete cache;
+            return 1;
+        }
+    } else {
+        executeEscapes(&grid, cache);
+    }
+
+    if (cache) {
+        double cacheStart = Statistics::now();
+
+        cache->save();
+        delete cache;
+
+        stats.addPhase("cache", Statistics::now() - cacheStart);
+    }
+
+    maxCount = histogram.maxCount();
+
+    stats.aggregate();
+
+    std::cout << "Calculated fractal" << std::endl;
+
+    return 0;
+}
+
+int Renderer::load(const std::string &fileName) {
+    release();
+    stats = Statistics();
+
+    PhaseTimer loadTimer(&stats, "load");
+
+    allocateHistogram();
+
+    CSVReader csv(fileName);
+    if (csv.read(&histogram) != 0) {
+        std::cout << "Failed to load fractal data from " << fileName << std::endl;
+        return 1;
+    }
+
+    maxCount = histogram.maxCount();
+
+    std::cout << "Loaded fractal" << std::endl;
+
+    return 0;
+}
+
+int Renderer::save(const std::string &fileName) {
+    return save(fileName, config);
+}
+
+int Renderer::save(const std::string &fileName, const RenderConfig &drawing) {
+    // a shard only holds part of the render, so is kept raw to be summed with the others by buddhabrot-merge
+    if (config.shardCount > 1) {
+        PhaseTimer histTimer(&stats, "hist");
+
+        HistogramFile partial(fileName + ".hist");
+        if (partial.write(&histogram, config) != 0) {
+            std::cout << "Failed to save partial histogram to " << fileName << ".hist" << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    CSVReader csv(fileName + ".csv");
+
+    double pngStart = Statistics::now();
+    int err;
+
+    if (drawing.pyramid) {
+        PyramidWriter pyramid(fileName, drawing.colourR, drawing.colourG, drawing.colourB, drawing.alpha, drawing.pngDepth, std::max(config.numThreads, 1u));
+        err = pyramid.write(&histogram);
+    } else {
+        PNGWriter picture(fileName + ".png", drawing.colourR, drawing.colourG, drawing.colourB, maxCount, drawing.alpha, drawing.pngDepth, std::max(config.numThreads, 1u));
+        err = picture.write(&histogram);
+    }
+
+    stats.addPhase(drawing.pyramid ? "pyramid" : "png", Statistics::now() - pngStart);
+    double csvStart = Statistics::now();
+
+    err |= csv.write(&histogram);
+
+    stats.addPhase("csv", Statistics::now() - csvStart);
+
+    // each projected view as a png of its own, scaled to its own brightest pixel
+    if (!projected.empty()) {
+        PhaseTimer viewsTimer(&stats, "png");
+
+        for (unsigned int v = 0; v < projected.size(); ++v) {
+            char suffix[32];
+            snprintf(suffix, sizeof(suffix), "_view%03u.png", v);
+
+            PNGWriter view(fileName + suffix, drawing.colourR, drawing.colourG, drawing.colourB, projected[v].maxCount(), drawing.alpha, drawing.pngDepth, std::max(config.numThreads, 1u));
+            err |= view.write(&projected[v]);
+        }
+    }
+    stats.aggregate();
+
+    return err;
+}
+
+void Renderer::executeEscapes(const SeedGrid *grid, SeedCache *cache) {
+    std::cout << "Memory successfully yoinked" << std::endl;
+
+    const unsigned int numThreads = std::max(config.numThreads, 1u);
+
+    stats.threads.resize(numThreads);
+
+    Topology topology;
+    if (config.pin)
+        topology = Topology::detect();
+
+    const bool pin = topology.canPin();
+
+    // every node bins into a copy of the histogram in its own memory, rather than half of the increments crossing
+    // the interconnect. Copies are only worth it while the threads stay on their nodes, and are left out when
+    // they would not fit in the memory budget, or there are projected views to bin into as well
+    const unsigned long long replicaBytes = sizeof(unsigned int) * histogram.size() * topology.nodeCount();
+    const bool replicate = pin && topology.nodeCount() > 1 && !histogram.fileBacked() && (config.maxMemory == 0 || replicaBytes <= config.maxMemory / 2) && projected.empty();
+
+    std::vector<Histogram> replicas(replicate ? topology.nodeCount() : 0);
+    std::vector<std::thread*> threads;
+
+    if (replicate) {
+        double allocationStart = Statistics::now();
+
+        // zeroing a copy from a thread on its node is what places its pages there, as linux allocates on first touch
+        for (unsigned int node = 0; node < replicas.size(); ++node) {
+            threads.push_back(new std::thread([this, &topology, &replicas, node]() {
+                Topology::pin(topology.node(node).cpus[0]);
+                replicas[node].allocate(histogram.width, histogram.height, histogram.minReal, histogram.minImag, histogram.cellWidth);
+            }));
+        }
+
+        for (unsigned int i = 0; i < threads.size(); ++i) {
+            threads[i]->join();
+            delete threads[i];
+        }
+
+        threads.clear();
+
+        stats.addPhase("allocation", Statistics::now() - allocationStart);
+
+        std::cout << "Binning into a histogram per NUMA node" << std::endl;
+    } else if (config.pin && !pin)
+        std::cout << "Unable to pin threads on this platform, leaving them to move freely" << std::endl;
+
+    double escapeStart = Statistics::now();
+
+    if (pin) {
+        // the calling thread is left unpinned, so it only waits
+        for (unsigned int i = 0; i < numThreads; ++i)
+            threads.push_back(new std::thread(&Renderer::executePinnedRowsEscapes, this, grid, cache, &topology, &replicas, i, numThreads));
+    } else {
+        for (unsigned int i = 0; i < numThreads - 1; ++i)
+            threads.push_back(new std::thread(&Renderer::executeRowsEscapes, this, grid, cache, &histogram, i, numThreads));
+
+        executeRowsEscapes(grid, cache, &histogram, numThreads - 1, numThreads);
+    }
+
+    for (unsigned int i = 0; i < threads.size(); ++i) {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    threads.clear();
+
+    stats.addPhase("escape", Statistics::now() - escapeStart);
+
+    if (replicate) {
+        PhaseTimer mergeTimer(&stats, "merge");
+
+        for (const Histogram &replica : replicas) {
+            for (unsigned long int i = 0; i < histogram.size(); ++i) {
+                unsigned int count = replica.get(i);
+
+                if (count != 0)
+                    histogram.add(i, count);
+            }
+        }
+    }
+}
+
+void Renderer::executePinnedRowsEscapes(const SeedGrid *grid, SeedCache *cache, const Topology *topology, std::vector<Histogram> *replicas, unsigned int threadId, unsigned int threadsTotal) {
+    unsigned int cpu;
+    unsigned int node = topology->place(threadId, &cpu);
+
+    Topology::pin(cpu);
+
+    executeRowsEscapes(grid, cache, replicas->empty() ? &histogram : &(*replicas)[node], threadId, threadsTotal);
+}
+
+void Renderer::executeRowsEscapes(const SeedGrid *grid, SeedCache *cache, Histogram *target, unsigned int threadId, unsigned int threadsTotal) {
+    double start = Statistics::now();
+
+    if (!projected.empty()) {
+        Views views(target, &projected, config.projections);
+
+        escapeRows(grid, cache, &views, &stats.threads[threadId], threadId, grid->rows, threadsTotal);
+    } else if (config.scatter) {
+        Scatter scatter(target);
+
+        escapeRows(grid, cache, &scatter, &stats.threads[threadId], threadId, grid->rows, threadsTotal);
+        scatter.flush();
+    } else
+        escapeRows(grid, cache, target, &stats.threads[threadId], threadId, grid->rows, threadsTotal);
+
+    stats.threads[threadId].busySeconds = Statistics::now() - start;
+}
+
+void Renderer::executeHybrid(const SeedGrid *grid, SeedCache *cache) {
+    std::cout << "Memory successfully yoinked" << std::endl;
+
+    const unsigned int numThreads = std::max(config.numThreads, 1u);
+
+    // the OpenCL dispatcher counts as one more thread, as it mostly waits on the device
+    stats.threads.resize(numThreads + 1);
+
+    ChunkQueue queue(grid->rows);
+
+    // both sides start on small chunks until their throughput is known, the device's first chunk also paying for
+    // building its kernels
+    std::vector<unsigned int> consumers;
+    for (unsigned int i = 0; i < numThreads; ++i)
+        consumers.push_back(queue.addConsumer(1));
+
+    const unsigned int device = queue.addConsumer(std::max(1u, grid->rows / 64));
+
+    double escapeStart = Statistics::now();
+
+    Statistics deviceStats;
+    std::thread dispatcher(&Renderer::dispatchQueuedRows, this, grid, cache, &queue, device, &deviceStats);
+
+    std::vector<std::thread*> threads;
+    for (unsigned int i = 0; i < numThreads - 1; ++i)
+        threads.push_back(new std::thread(&Renderer::executeQueuedRows, this, grid, cache, &queue, consumers[i], i));
+
+    executeQueuedRows(grid, cache, &queue, consumers[numThreads - 1], numThreads - 1);
+
+    for (unsigned int i = 0; i < threads.size(); ++i) {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    dispatcher.join();
+
+    stats.addPhase("escape", Statistics::now() - escapeStart);
+
+    // the device's own counters and phases go alongside the CPU's, its seeds having been binned in the same histogram
+    ThreadCounters &deviceCounters = stats.threads[numThreads];
+    deviceCounters.add(deviceStats.total);
+    deviceCounters.busySeconds = deviceStats.phase("check") + deviceStats.phase("compaction") + deviceStats.phase("count") + deviceStats.phase("reduction");
+
+    for (const std::pair<std::string, double> &phase : deviceStats.phases)
+        stats.addPhase("opencl " + phase.first, phase.second);
+
+    stats.kernelLaunches += deviceStats.kernelLaunches;
+    stats.backend = "hybrid";
+    stats.iterationsTracked = false;
+
+    std::cout << "Rows per second := " << (unsigned int)queue.rate(device) << " OpenCL, " << (unsigned int)(queue.rate(consumers[0]) * numThreads) << " CPU" << std::endl;
+}
+
+void Renderer::executeQueuedRows(const SeedGrid *grid, SeedCache *cache, ChunkQueue *queue, unsigned int consumer, unsigned int threadId) {
+    double start = Statistics::now();
+
+    ThreadCounters *counters = &stats.threads[threadId];
+
+    Views *views = !projected.empty() ? new Views(&histogram, &projected, config.projections) : NULL;
+    Scatter *scatter = config.scatter && !views ? new Scatter(&histogram) : NULL;
+
+    unsigned int first, count;
+
+    while (queue->take(consumer, &first, &count)) {
+        double chunkStart = Statistics::now();
+
+        if (views)
+            escapeRows(grid, cache, views, counters, first, first + count, 1);
+        else if (scatter)
+            escapeRows(grid, cache, scatter, counters, first, first + count, 1);
+        else
+            escapeRows(grid, cache, &histogram, counters, first, first + count, 1);
+
+        queue->finished(consumer, count, Statistics::now() - chunkStart);
+    }
+
+    delete views;
+    delete scatter;
+
+    counters->busySeconds = Statistics::now() - start;
+}
+
+void Renderer::dispatchQueuedRows(const SeedGrid *grid, SeedCache *cache, ChunkQueue *queue, unsigned int consumer, Statistics *deviceStats) {
+    unsigned int first, count;
+    bool failed = false;
+
+    while (queue->take(consumer, &first, &count)) {
+        double chunkStart = Statistics::now();
+
+        // without a device, its chunks are binned on this thread instead, so that the render still completes. A
+        // chunk that failed part way through its bands only has the rest of the rows binned again
+        unsigned int committedRows = 0;
+
+        if (!failed && helper->calculateCells(&histogram, &projected, config, *grid, cache, deviceStats, first, first + count, &committedRows) != 0) {
+            std::cout << "OpenCL failed, binning the rest of its rows on the CPU" << std::endl;
+            failed = true;
+
+            escapeUncommittedRows(grid, cache, &deviceStats->total, first, first + count, committedRows);
+        } else if (failed)
+            escapeUncommittedRows(grid, cache, &deviceStats->total, first, first + count, 0);
+
+        queue->finished(consumer, count, Statistics::now() - chunkStart);
+    }
+}
+
+void Renderer::escapeUncommittedRows(const SeedGrid *grid, SeedCache *cache, ThreadCounters *counters, unsigned int first, unsigned int last, unsigned int committedRows) {
+    if (committedRows == 0) {
+        Views views(&histogram, &projected, config.projections);
+
+        if (!projected.empty())
+            escapeRows(grid, cache, &views, counters, first, last, 1);
+        else
+            escapeRows(grid, cache, &histogram, counters, first, last, 1);
+
+        return;
+    }
+
+    if (committedRows >= histogram.height)
+        return;
+
+    // the orbits are binned into histograms of only the remaining rows, which every view shares the geometry of,
+    // and then added on past the committed rows
+    const unsigned int rows = histogram.height - committedRows;
+    const unsigned long long memory = config.maxMemory / (projected.size() + 1);
+
+    Histogram rest;
+    rest.allocate(histogram.width, rows, histogram.pixelReal(committedRows), histogram.minImag, histogram.cellWidth, memory);
+
+    std::vector<Histogram> restProjected(projected.size());
+    for (Histogram &view : restProjected)
+        view.allocate(histogram.width, rows, histogram.pixelReal(committedRows), histogram.minImag, histogram.cellWidth, memory);
+
+    if (!projected.empty()) {
+        Views views(&rest, &restProjected, config.projections);
+        escapeRows(grid, cache, &views, counters, first, last, 1);
+    } else
+        escapeRows(grid, cache, &rest, counters, first, last, 1);
+
+    const unsigned long int offset = (unsigned long int)committedRows * histogram.width;
+
+    for (unsigned int v = 0; v <= projected.size(); ++v) {
+        Histogram *source = v == 0 ? &rest : &restProjected[v - 1];
+        Histogram *target = v == 0 ? &histogram : &projected[v - 1];
+
+        for (unsigned long int i = 0; i < source->size(); ++i) {
+            const unsigned int count = source->get(i);
+            if (count != 0)
+                target->add(offset + i, count);
+        }
+    }
+}
+
+int Renderer::executeSampled(const SeedGrid *grid) {
+    std::cout << "Memory successfully yoinked" << std::endl;
+
+    const unsigned int numThreads = std::max(config.numThreads, 1u);
+    const bool device = config.usesOpenCL();
+
+    stats.threads.resize(device ? 0 : numThreads);
+
+    const Halton halton;
+    std::vector<unsigned int> previous(histogram.size());
+
+    const double start = Statistics::now();
+    double sampleSeconds = 0;
+
+    uint64_t next = 0;
+    uint64_t round = SAMPLES_FIRST_ROUND;
+
+    // the change over a round is only known from the second round on. A round cut short by the time limit moves
+    // the histogram less than a whole one would, so is the last rather than a sign that it has settled
+    bool lastRound = false;
+
+    while (true) {
+        double roundStart = Statistics::now();
+
+        if (device) {
+            if (dispatchSampleRange(grid, &halton, next, next + round) != 0)
+                return 1;
+        } else {
+            std::vector<std::thread*> threads;
+
+            // contiguous ranges of indices, each of which is spread evenly over the seed domain by itself
+            for (unsigned int i = 0; i < numThreads - 1; ++i)
+                threads.push_back(new std::thread(&Renderer::executeSampleRange, this, grid, &halton, next + round * i / numThreads, next + round * (i + 1) / numThreads, i));
+
+            executeSampleRange(grid, &halton, next + round * (numThreads - 1) / numThreads, next + round, numThreads - 1);
+
+            for (unsigned int i = 0; i < threads.size(); ++i) {
+                threads[i]->join();
+                delete threads[i];
+            }
+        }
+
+        next += round;
+        sampleSeconds += Statistics::now() - roundStart;
+
+        double convergenceStart = Statistics::now();
+        const double change = histogramChange(histogram, &previous);
+        stats.addPhase("convergence", Statistics::now() - convergenceStart);
+
+        std::cout << "Seeds drawn := " << next << ", change := " << change << std::endl;
+
+        if (lastRound) {
+            std::cout << "Time limit reached after " << next << " seeds" << std::endl;
+            break;
+        }
+
+        if (next > SAMPLES_FIRST_ROUND && change < config.tolerance) {
+            std::cout << "Histogram settled after " << next << " seeds" << std::endl;
+            break;
+        }
+
+        round = next;
+
+        if (config.timeLimit > 0) {
+            const double remaining = config.timeLimit - (Statistics::now() - start);
+            const uint64_t affordable = (uint64_t)std::max(0.0, remaining * next / std::max(sampleSeconds, 1E-9));
+
+            if (affordable < round) {
+                round = affordable;
+                lastRound = true;
+            }
+
+            if (round < SAMPLES_FIRST_ROUND / 16) {
+                std::cout << "Time limit reached after " << next << " seeds" << std::endl;
+                break;
+            }
+        }
+    }
+
+    stats.addPhase("escape", sampleSeconds);
+
+    return 0;
+}
+
+void Renderer::executeSampleRange(const SeedGrid *grid, const Halton *halton, uint64_t first, uint64_t last, unsigned int threadId) {
+    double start = Statistics::now();
+
+    if (!projected.empty()) {
+        Views views(&histogram, &projected, config.projections);
+
+        escapeSamples(grid, halton, &views, &stats.threads[threadId], first, last);
+    } else if (config.scatter) {
+        Scatter scatter(&histogram);
+
+        escapeSamples(grid, halton, &scatter, &stats.threads[threadId], first, last);
+        scatter.flush();
+    } else
+        escapeSamples(grid, halton, &histogram, &stats.threads[threadId], first, last);
+
+    stats.threads[threadId].busySeconds += Statistics::now() - start;
+}
+
+int Renderer::dispatchSampleRange(const SeedGrid *grid, const Halton *halton, uint64_t first, uint64_t last) {
+    for (uint64_t dispatch = first; dispatch < last; dispatch += SAMPLES_PER_DISPATCH) {
+        std::vector<double> seeds;
+
+        for (uint64_t i = dispatch; i < std::min(last, dispatch + SAMPLES_PER_DISPATCH); ++i) {
+            const ComplexNumber c = sampleSeed(grid, halton, i);
+
+            if (!grid->activeAt(c))
+                continue;
+
+            seeds.push_back((double)c.real);
+            seeds.push_back((double)c.imag);
+        }
+
+        // with symmetry, every seed is drawn from the upper half so stands in for its conjugate
+        const cl_uint mirrorCount = grid->symmetric ? (cl_uint)(seeds.size() / 2) : 0;
+
+        if (helper->calculateSeeds(&histogram, &projected, config, seeds, mirrorCount, &stats) != 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+template <class Sink>
+void Renderer::escapeSamples(const SeedGrid *grid, const Halton *halton, Sink *target, ThreadCounters *counters, uint64_t first, uint64_t last) {
+    const Power power(config.power, config.cycles);
+
+    std::vector<unsigned long int> visited;
+
+    for (uint64_t i = first; i < last; ++i) {
+        const ComplexNumber c = sampleSeed(grid, halton, i);
+
+        if (grid->activeAt(c))
+            Orbit::escape(c, target, config.iterations, power, config.anti, grid->symmetric, &visited, counters);
+    }
+}
+
+ComplexNumber Renderer::sampleSeed(const SeedGrid *grid, const Halton *halton, uint64_t index) const {
+    long double x, y;
+    halton->point(index, &x, &y);
+
+    const long double minImag = grid->symmetric ? 0 : config.seedMin.second;
+
+    return ComplexNumber(config.seedMin.first + x * (config.seedMax.first - config.seedMin.first), minImag + y * (config.seedMax.second - minImag));
+}
+
+template <class Sink>
+void Renderer::escapeRows(const SeedGrid *grid, SeedCache *cache, Sink *target, ThreadCounters *counters, unsigned int firstRow, unsigned int lastRow, unsigned int step) {
+    const Power power(config.power, config.cycles);
+
+    std::vector<unsigned long int> visited; // reused between orbits so it only grows a handful of times
+
+    for (unsigned int row = firstRow; row < lastRow; row += step) {
+        if (!grid->rowActive(row))
+            continue;
+
+        for (unsigned int column = 0; column < grid->columns; ++column) {
+            SeedKind kind = grid->kind(row, column);
+
+            if (kind == SEED_SKIPPED)
+                continue;
+
+            // seeds known not to contribute, from the cache or the interior check, are skipped entirely, and known
+            // contributing seeds are binned without having to hold on to their orbits
+            unsigned long int index = grid->index(row, column);
+            SeedClass known = grid->classification(row, column);
+
+            bool contributes;
+
+            if (cache && (cache->state(index) & SEED_CHECKED)) {
+                if (cache->state(index) & SEED_CONTRIBUTING)
+                    Orbit::bin(grid->seed(row, column), target, config.iterations, power, kind == SEED_MIRRORED, counters);
+
+                continue;
+            } else if (known != SEED_UNCLASSIFIED) {
+                contributes = (known == SEED_ESCAPES) != config.anti;
+
+                if (contributes)
+                    Orbit::bin(grid->seed(row, column), target, config.iterations, power, kind == SEED_MIRRORED, counters);
+            } else
+                contributes = Orbit::escape(grid->seed(row, column), target, config.iterations, power, config.anti, kind == SEED_MIRRORED, &visited, counters);
+
+            if (cache)
+                cache->record(index, contributes);
+        }
+    }
+}
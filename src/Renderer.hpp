@@ -0,0 +1,101 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "ChunkQueue.hpp"
+#include "Halton.hpp"
+#include "Histogram.hpp"
+#include "OpenCLKernelHelper.hpp"
+#include "RenderConfig.hpp"
+#include "SeedCache.hpp"
+#include "SeedGrid.hpp"
+#include "Statistics.hpp"
+#include "Topology.hpp"
+#include "Views.hpp"
+
+#include <string>
+#include <vector>
+
+#ifndef Renderer_hpp
+#define Renderer_hpp
+
+// a single buddhabrot render. Every buffer belongs to the renderer, so any number of them can run at once on
+// different threads. OpenCL renders go through a shared OpenCLKernelHelper which keeps the context, queues and
+// built programs alive between renders
+class Renderer {
+private:
+    RenderConfig config;
+    OpenCLKernelHelper *helper;
+
+    Histogram histogram;
+    unsigned int maxCount;
+
+    std::vector<Histogram> projected; // one per config.projections, covering the same viewport as histogram
+
+    Statistics stats;
+
+    // bins the seeds of every step-th row from firstRow up to lastRow
+    template <class Sink>
+    void escapeRows(const SeedGrid *grid, SeedCache *cache, Sink *target, ThreadCounters *counters, unsigned int firstRow, unsigned int lastRow, unsigned int step);
+
+    void executeRowsEscapes(const SeedGrid *grid, SeedCache *cache, Histogram *target, unsigned int threadId, unsigned int threadsTotal);
+    void executePinnedRowsEscapes(const SeedGrid *grid, SeedCache *cache, const Topology *topology, std::vector<Histogram> *replicas, unsigned int threadId, unsigned int threadsTotal);
+    void executeEscapes(const SeedGrid *grid, SeedCache *cache);
+
+    // the CPU workers and the OpenCL device pulling chunks of rows from one queue, all binning into the histogram
+    void executeHybrid(const SeedGrid *grid, SeedCache *cache);
+    void executeQueuedRows(const SeedGrid *grid, SeedCache *cache, ChunkQueue *queue, unsigned int consumer, unsigned int threadId);
+    void dispatchQueuedRows(const SeedGrid *grid, SeedCache *cache, ChunkQueue *queue, unsigned int consumer, Statistics *deviceStats);
+
+    // bins the seeds of rows first up to last on this thread, into only the rows of the histogram and views from
+    // committedRows on, as the device already added the rows before them when it failed part way through
+    void escapeUncommittedRows(const SeedGrid *grid, SeedCache *cache, ThreadCounters *counters, unsigned int first, unsigned int last, unsigned int committedRows);
+    // draws seeds from the Halton sequence in rounds of doubling size, until the histogram settles or time runs out
+    int executeSampled(const SeedGrid *grid);
+    void executeSampleRange(const SeedGrid *grid, const Halton *halton, uint64_t first, uint64_t last, unsigned int threadId);
+    int dispatchSampleRange(const SeedGrid *grid, const Halton *halton, uint64_t first, uint64_t last);
+
+    // bins the seeds drawn at indices first up to last of the sequence
+    template <class Sink>
+    void escapeSamples(const SeedGrid *grid, const Halton *halton, Sink *target, ThreadCounters *counters, uint64_t first, uint64_t last);
+
+    // the seed drawn at index, from the seed domain, or from its upper half standing in for both halves when the
+    // render is symmetric
+    ComplexNumber sampleSeed(const SeedGrid *grid, const Halton *halton, uint64_t index) const;
+
+    void allocateHistogram();
+    void release();
+
+public:
+    // without a helper, OpenCL renders go through the shared helper of config.device
+    Renderer(const RenderConfig &config, OpenCLKernelHelper *helper = NULL) : config(config), helper(helper ? helper : OpenCLKernelHelper::shared(config.device)), maxCount(0) {};
+    ~Renderer();
+
+    Renderer(const Renderer&) = delete;
+    Renderer &operator=(const Renderer&) = delete;
+
+    int render();
+    int load(const std::string &fileName);
+    int save(const std::string &fileName);
+
+    // saves the histogram drawn with the colour, alpha, png depth and pyramid of drawing rather than of the render's
+    // own config, so that every job sharing the histogram can be saved its own way
+    int save(const std::string &fileName, const RenderConfig &drawing);
+
+    const RenderConfig &getConfig() const { return config; };
+    RenderConfig &getConfig() { return config; };
+
+    const Histogram &getHistogram() const { return histogram; };
+    const std::vector<Histogram> &getProjected() const { return projected; };
+
+    unsigned int getMaxCount() const { return maxCount; };
+
+    Statistics *getStatistics() { return &stats; };
+};
+
+#endif // Renderer_hpp
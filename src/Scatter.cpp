@@ -0,0 +1,63 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Scatter.hpp"
+
+#include "Topology.hpp"
+
+#include <algorithm>
+
+// bytes of a cache line, for sizing the buckets
+static const unsigned int CACHE_LINE = 64;
+
+unsigned long int Scatter::tileCells() {
+    // a tile takes half of the L2, leaving the rest for the buckets being applied and the orbits themselves,
+    // rounded down to a power of two so that finding an index's tile is a shift
+    static const unsigned long int cells = [] {
+        unsigned long int target = Topology::cacheSize(2, SCATTER_DEFAULT_L2) / 2 / sizeof(unsigned int);
+        unsigned long int result = 1024;
+
+        while (result * 2 <= target)
+            result *= 2;
+
+        return result;
+    }();
+
+    return cells;
+}
+
+unsigned int Scatter::bucketCapacity() {
+    // a couple of increments per cache line of the tile, so that applying a bucket touches each line more than once
+    return (unsigned int)std::max(1024UL, 2 * tileCells() * sizeof(unsigned int) / CACHE_LINE);
+}
+
+Scatter::Scatter(Histogram *histogram) : histogram(histogram), tileShift(0), capacity(bucketCapacity()) {
+    while ((1UL << tileShift) < tileCells())
+        ++tileShift;
+
+    const unsigned long int tiles = (histogram->size() >> tileShift) + 1;
+
+    buckets.resize(tiles * capacity);
+    fill.assign(tiles, 0);
+}
+
+void Scatter::flush(unsigned long int tile) {
+    const unsigned long int first = tile << tileShift;
+    const unsigned int *bucket = &buckets[tile * capacity];
+
+    for (unsigned int i = 0; i < fill[tile]; ++i)
+        histogram->increment(first + bucket[i]);
+
+    fill[tile] = 0;
+}
+
+void Scatter::flush() {
+    for (unsigned long int tile = 0; tile < fill.size(); ++tile)
+        flush(tile);
+}
@@ -0,0 +1,66 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Histogram.hpp"
+
+#include <vector>
+
+#ifndef Scatter_hpp
+#define Scatter_hpp
+
+// L2 size assumed when it cannot be read from the system
+static const unsigned long int SCATTER_DEFAULT_L2 = 256 << 10;
+
+// a worker's buffered increments into a histogram. Orbits land all over a large histogram, so instead of
+// incrementing straight away, every index is appended to the bucket of the tile of the histogram it is in. A full
+// bucket is applied in one go, so that its increments all land in a tile small enough to stay in the L2 cache,
+// rather than each one missing the cache and the TLB. Stands in for the histogram in Orbit's escape and bin
+class Scatter {
+private:
+    Histogram *histogram;
+
+    unsigned int tileShift; // a tile is 1 << tileShift counts
+    unsigned int capacity;  // increments buffered per tile
+
+    std::vector<unsigned int> buckets; // capacity offsets into each tile, one tile after another
+    std::vector<unsigned int> fill;
+
+    void flush(unsigned long int tile);
+
+public:
+    Scatter(Histogram *histogram);
+    ~Scatter() { flush(); };
+
+    Scatter(const Scatter&) = delete;
+    Scatter &operator=(const Scatter&) = delete;
+
+    inline bool index(long double real, long double imag, unsigned long int *index) const { return histogram->index(real, imag, index); };
+    inline bool index(long double real, long double imag, unsigned long int *index, unsigned long int *mirrored) const { return histogram->index(real, imag, index, mirrored); };
+
+    inline void increment(unsigned long int index) {
+        const unsigned long int tile = index >> tileShift;
+
+        buckets[tile * capacity + fill[tile]] = (unsigned int)(index & ((1UL << tileShift) - 1));
+
+        if (++fill[tile] == capacity)
+            flush(tile);
+    };
+
+    // a cycle's repeated points come in far fewer, larger adds, so they go straight to the histogram
+    inline void add(unsigned long int index, unsigned int amount) { histogram->add(index, amount); };
+
+    // applies every buffered increment
+    void flush();
+
+    // counts per tile and increments per bucket, as chosen from the L2 size
+    static unsigned long int tileCells();
+    static unsigned int bucketCapacity();
+};
+
+#endif // Scatter_hpp
@@ -0,0 +1,68 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "SeedCache.hpp"
+
+#include "io/BitmapFile.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+
+// FNV-1a, which is plenty to tell apart a handful of cached grids
+static uint64_t hashString(const std::string &text) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (char c : text) {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+SeedCache::SeedCache(const std::string &directory, const RenderConfig &config, const SeedGrid &grid, unsigned int precision) : loaded(0) {
+    char key[512];
+    snprintf(key, sizeof(key), "%.21Lg,%.21Lg,%.21Lg,%u,%u,%u,%.21Lg,%d,%u", grid.minReal, grid.minImag, grid.spacing, grid.rows, grid.columns, config.iterations, config.power, (int)config.anti, precision);
+
+    char name[32];
+    snprintf(name, sizeof(name), "seeds_%016llx.rle", (unsigned long long)hashString(key));
+
+    fname = directory + "/" + name;
+
+    states.assign(grid.count(), 0);
+}
+
+int SeedCache::load() {
+    BitmapFile file(fname);
+
+    if (file.read(&states, 2) != 0)
+        return 1;
+
+    loaded = 0;
+    for (unsigned char state : states)
+        loaded += (state & SEED_CHECKED) != 0;
+
+    std::cout << "Loaded seed cache " << fname << " := " << loaded << '/' << states.size() << " seeds checked" << std::endl;
+
+    return 0;
+}
+
+int SeedCache::save() {
+    BitmapFile file(fname);
+
+    if (file.write(states, 2) != 0) {
+        std::cout << "Failed to save seed cache to " << fname << std::endl;
+        return 1;
+    }
+
+    std::cout << "Saved seed cache to " << fname << std::endl;
+
+    return 0;
+}
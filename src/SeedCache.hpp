@@ -0,0 +1,49 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "RenderConfig.hpp"
+#include "SeedGrid.hpp"
+
+#include <string>
+#include <vector>
+
+#ifndef SeedCache_hpp
+#define SeedCache_hpp
+
+// bits of a seed's state
+static const unsigned char SEED_CHECKED = 1;
+static const unsigned char SEED_CONTRIBUTING = 2;
+
+// which seeds of a grid are known to contribute, kept between runs in a directory. The set only depends on the
+// seed grid, iterations, anti and precision, not on the viewport or colours, so those can change freely between
+// runs. Seeds are only checked as they are needed, e.g after culling, and the cache fills in over many runs
+class SeedCache {
+private:
+    std::string fname;
+
+    std::vector<unsigned char> states;
+    unsigned long int loaded;
+
+public:
+    SeedCache(const std::string &directory, const RenderConfig &config, const SeedGrid &grid, unsigned int precision);
+
+    int load();
+    int save();
+
+    inline unsigned char state(unsigned long int index) const { return states[index]; };
+
+    // different seeds can be recorded from different threads at once
+    inline void record(unsigned long int index, bool contributes) { states[index] = SEED_CHECKED | (contributes ? SEED_CONTRIBUTING : 0); };
+
+    unsigned long int loadedCount() const { return loaded; };
+
+    const std::string &getFileName() const { return fname; };
+};
+
+#endif // SeedCache_hpp
@@ -0,0 +1,276 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "SeedGrid.hpp"
+
+#include "Orbit.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <thread>
+
+SeedGrid::SeedGrid(const RenderConfig &config) {
+    minReal = config.seedMin.first;
+    minImag = config.seedMin.second;
+
+    columns = config.seedColumns();
+    spacing = (config.seedMax.second - config.seedMin.second) / columns;
+    rows = std::max(1u, (unsigned int)round((config.seedMax.first - config.seedMin.first) / spacing));
+
+    shardIndex = config.shardIndex;
+    shardCount = std::max(config.shardCount, 1u);
+
+    symmetric = config.symmetric();
+    mirrorSum = (long int)round(-2 * minImag / spacing);
+
+    axisColumn = mirrorSum >= 0 && mirrorSum % 2 == 0 && fabsl(minImag + spacing * (mirrorSum / 2)) < spacing * 1E-6 ? mirrorSum / 2 : -1;
+
+    tileSize = std::max(1u, (std::max(rows, columns) + CULL_TILES_PER_ROW - 1) / CULL_TILES_PER_ROW);
+    tileRows = (rows + tileSize - 1) / tileSize;
+    tileColumns = (columns + tileSize - 1) / tileSize;
+
+    activeTiles.assign((unsigned long int)tileRows * tileColumns, true);
+}
+
+bool SeedGrid::rowActive(unsigned int row) const {
+    // bands of rows are dealt out to the shards in turn, so every shard gets a similar mix of cheap and expensive
+    // rows. Bands are as tall as the interior check's blocks, so that each block belongs to a single shard and no
+    // shard iterates the borders of another's
+    if ((row / INTERIOR_BLOCK_SIZE) % shardCount != shardIndex)
+        return false;
+
+    unsigned long int start = (unsigned long int)(row / tileSize) * tileColumns;
+
+    return std::find(activeTiles.begin() + start, activeTiles.begin() + start + tileColumns, true) != activeTiles.begin() + start + tileColumns;
+}
+
+bool SeedGrid::activeAt(const ComplexNumber &c) const {
+    const unsigned int row = (unsigned int)std::min(std::max(floorl((c.real - minReal) / spacing), 0.0L), (long double)rows - 1);
+    const unsigned int column = (unsigned int)std::min(std::max(floorl((c.imag - minImag) / spacing), 0.0L), (long double)columns - 1);
+
+    if (active(row, column))
+        return true;
+
+    const long int mirror = mirrorSum - column;
+
+    return symmetric && mirror >= 0 && mirror < (long int)columns && active(row, mirror);
+}
+
+unsigned long int SeedGrid::activeCount() const {
+    unsigned long int result = 0;
+
+    for (unsigned int i = 0; i < tileRows; ++i) {
+        for (unsigned int j = 0; j < tileColumns; ++j) {
+            if (activeTiles[i * tileColumns + j])
+                result += (unsigned long int)(std::min(rows, (i + 1) * tileSize) - i * tileSize) * (std::min(columns, (j + 1) * tileSize) - j * tileSize);
+        }
+    }
+
+    return result;
+}
+
+unsigned long int SeedGrid::evaluatedCount() const {
+    unsigned long int result = 0;
+
+    for (unsigned int i = 0; i < rows; ++i) {
+        if (!rowActive(i))
+            continue;
+
+        for (unsigned int j = 0; j < columns; ++j)
+            result += kind(i, j) != SEED_SKIPPED;
+    }
+
+    return result;
+}
+
+bool SeedGrid::cullable(const Histogram *histogram, const RenderConfig &config) const {
+    const bool viewportCoversSeeds = histogram->minReal <= minReal && histogram->minImag <= minImag &&
+        histogram->pixelReal(histogram->height) >= config.seedMax.first && histogram->pixelImag(histogram->width) >= config.seedMax.second;
+
+    return config.cull && config.projections.empty() && !viewportCoversSeeds;
+}
+
+void SeedGrid::cull(const Histogram *histogram, const RenderConfig &config) {
+    const Power power(config.power, config.cycles);
+    unsigned int numThreads = std::max(config.numThreads, 1u);
+
+    std::vector<char> touched((unsigned long int)tileRows * tileColumns, 0);
+
+    // tiles are handed out round robin, each thread only writing to the tiles it owns
+    auto sampleTiles = [&](unsigned int threadId) {
+        for (unsigned long int tile = threadId; tile < touched.size(); tile += numThreads) {
+            unsigned int tileRow = tile / tileColumns;
+            unsigned int tileColumn = tile % tileColumns;
+
+            for (unsigned int i = 0; i < CULL_SAMPLES_PER_TILE && !touched[tile]; ++i) {
+                for (unsigned int j = 0; j < CULL_SAMPLES_PER_TILE && !touched[tile]; ++j) {
+                    long double row = tileRow * tileSize + (i + 0.5) * tileSize / CULL_SAMPLES_PER_TILE;
+                    long double column = tileColumn * tileSize + (j + 0.5) * tileSize / CULL_SAMPLES_PER_TILE;
+
+                    ComplexNumber c(minReal + spacing * row, minImag + spacing * column);
+
+                    if (Orbit::touches(c, histogram, config.iterations, power, config.anti))
+                        touched[tile] = 1;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (unsigned int i = 0; i < numThreads - 1; ++i)
+        threads.push_back(std::thread(sampleTiles, i));
+
+    sampleTiles(numThreads - 1);
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    for (unsigned int i = 0; i < tileRows; ++i) {
+        for (unsigned int j = 0; j < tileColumns; ++j) {
+            bool active = false;
+
+            for (int di = -1; di <= 1 && !active; ++di) {
+                for (int dj = -1; dj <= 1 && !active; ++dj) {
+                    int ni = i + di;
+                    int nj = j + dj;
+
+                    if (ni >= 0 && nj >= 0 && ni < (int)tileRows && nj < (int)tileColumns)
+                        active = touched[ni * tileColumns + nj] != 0;
+                }
+            }
+
+            activeTiles[i * tileColumns + j] = active;
+        }
+    }
+}
+
+bool SeedGrid::blockEvaluated(unsigned int firstRow, unsigned int firstColumn, unsigned int lastRow, unsigned int lastColumn) const {
+    for (unsigned int i = firstRow; i <= lastRow; ++i) {
+        if (!rowActive(i))
+            continue;
+
+        for (unsigned int j = firstColumn; j <= lastColumn; ++j) {
+            if (kind(i, j) != SEED_SKIPPED)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void SeedGrid::classifyRectangle(unsigned int firstRow, unsigned int firstColumn, unsigned int lastRow, unsigned int lastColumn, unsigned int iterations, const Power &power, unsigned long int *iterated) {
+    bool bounded = true;
+
+    // walks the border once, iterating only the seeds that a neighbouring rectangle has not already
+    for (unsigned int i = firstRow; i <= lastRow; ++i) {
+        const bool edgeRow = i == firstRow || i == lastRow;
+
+        for (unsigned int j = firstColumn; j <= lastColumn; j = edgeRow || j == lastColumn ? j + 1 : lastColumn) {
+            unsigned char *state = &classes[index(i, j)];
+
+            if (*state == SEED_UNCLASSIFIED) {
+                *state = Orbit::escapes(seed(i, j), iterations, power) ? SEED_ESCAPES : SEED_BOUNDED;
+                ++*iterated;
+            }
+
+            bounded = bounded && *state == SEED_BOUNDED;
+        }
+    }
+
+    if (lastRow - firstRow < 2 || lastColumn - firstColumn < 2)
+        return;
+
+    if (bounded) {
+        for (unsigned int i = firstRow + 1; i < lastRow; ++i)
+            std::fill(classes.begin() + index(i, firstColumn + 1), classes.begin() + index(i, lastColumn), (unsigned char)SEED_BOUNDED);
+
+        return;
+    }
+
+    // the seeds inside of small rectangles that straddle the boundary are left to be iterated by the render itself
+    const bool splitRows = lastRow - firstRow >= INTERIOR_MIN_SIZE;
+    const bool splitColumns = lastColumn - firstColumn >= INTERIOR_MIN_SIZE;
+
+    if (!splitRows && !splitColumns)
+        return;
+
+    const unsigned int middleRow = splitRows ? (firstRow + lastRow) / 2 : lastRow;
+    const unsigned int middleColumn = splitColumns ? (firstColumn + lastColumn) / 2 : lastColumn;
+
+    classifyRectangle(firstRow, firstColumn, middleRow, middleColumn, iterations, power, iterated);
+
+    if (splitColumns)
+        classifyRectangle(firstRow, middleColumn, middleRow, lastColumn, iterations, power, iterated);
+
+    if (splitRows) {
+        classifyRectangle(middleRow, firstColumn, lastRow, middleColumn, iterations, power, iterated);
+
+        if (splitColumns)
+            classifyRectangle(middleRow, middleColumn, lastRow, lastColumn, iterations, power, iterated);
+    }
+}
+
+void SeedGrid::blockBounds(unsigned long int block, unsigned int *firstRow, unsigned int *firstColumn, unsigned int *lastRow, unsigned int *lastColumn) const {
+    *firstRow = (unsigned int)(block / blockColumns()) * INTERIOR_BLOCK_SIZE;
+    *firstColumn = (unsigned int)(block % blockColumns()) * INTERIOR_BLOCK_SIZE;
+    *lastRow = std::min(rows, *firstRow + INTERIOR_BLOCK_SIZE) - 1;
+    *lastColumn = std::min(columns, *firstColumn + INTERIOR_BLOCK_SIZE) - 1;
+}
+
+bool SeedGrid::blockEvaluated(unsigned long int block) const {
+    unsigned int firstRow, firstColumn, lastRow, lastColumn;
+    blockBounds(block, &firstRow, &firstColumn, &lastRow, &lastColumn);
+
+    return blockEvaluated(firstRow, firstColumn, lastRow, lastColumn);
+}
+
+unsigned long int SeedGrid::classifyInterior(const RenderConfig &config, unsigned long int *iterated) {
+    std::vector<unsigned long int> blocks((unsigned long int)blockRows() * blockColumns());
+    for (unsigned long int block = 0; block < blocks.size(); ++block)
+        blocks[block] = block;
+
+    return classifyBlocks(config, blocks, iterated);
+}
+
+unsigned long int SeedGrid::classifyBlocks(const RenderConfig &config, const std::vector<unsigned long int> &blocks, unsigned long int *iterated) {
+    const Power power(config.power, config.cycles);
+    unsigned int numThreads = std::max(config.numThreads, 1u);
+
+    classes.assign(count(), SEED_UNCLASSIFIED);
+
+    std::vector<unsigned long int> threadIterated(numThreads, 0);
+
+    // blocks do not share any seeds, so each thread only ever writes to the blocks it owns
+    auto classifyOwnBlocks = [&](unsigned int threadId) {
+        for (unsigned long int i = threadId; i < blocks.size(); i += numThreads) {
+            unsigned int firstRow, firstColumn, lastRow, lastColumn;
+            blockBounds(blocks[i], &firstRow, &firstColumn, &lastRow, &lastColumn);
+
+            if (blockEvaluated(firstRow, firstColumn, lastRow, lastColumn))
+                classifyRectangle(firstRow, firstColumn, lastRow, lastColumn, config.iterations, power, &threadIterated[threadId]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (unsigned int i = 0; i < numThreads - 1; ++i)
+        threads.push_back(std::thread(classifyOwnBlocks, i));
+
+    classifyOwnBlocks(numThreads - 1);
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    *iterated = 0;
+    for (unsigned long int n : threadIterated)
+        *iterated += n;
+
+    return count() - std::count(classes.begin(), classes.end(), (unsigned char)SEED_UNCLASSIFIED);
+}
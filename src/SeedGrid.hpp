@@ -0,0 +1,145 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "ComplexNumber.hpp"
+#include "Histogram.hpp"
+#include "Orbit.hpp"
+#include "RenderConfig.hpp"
+
+#include <vector>
+
+#ifndef SeedGrid_hpp
+#define SeedGrid_hpp
+
+// tiles per side of the seed grid used by the culling pre-pass, and how many seeds per side are sampled in each
+static const unsigned int CULL_TILES_PER_ROW = 64;
+static const unsigned int CULL_SAMPLES_PER_TILE = 4;
+
+// blocks of seeds per side that the interior pre-pass starts from, and the smallest rectangle it splits further
+static const unsigned int INTERIOR_BLOCK_SIZE = 32;
+static const unsigned int INTERIOR_MIN_SIZE = 8;
+
+// how a seed is evaluated. With symmetry, MIRRORED seeds stand in for their conjugates, which are SKIPPED, and
+// AXIS seeds lie on the real axis so are their own conjugate. Seeds whose conjugate is not in the grid are PLAIN
+enum SeedKind {
+    SEED_SKIPPED,
+    SEED_PLAIN,
+    SEED_MIRRORED,
+    SEED_AXIS
+};
+
+// what the interior pre-pass found out about a seed, either by iterating it or from the border around it
+enum SeedClass {
+    SEED_UNCLASSIFIED,
+    SEED_ESCAPES,
+    SEED_BOUNDED
+};
+
+// the grid of seeds c that orbits are started from, split into square tiles that can be switched off when none
+// of their orbits reach the viewport
+class SeedGrid {
+private:
+    std::vector<bool> activeTiles;
+    std::vector<unsigned char> classes; // SeedClass of every seed, empty if the interior pre-pass has not ran
+
+    bool blockEvaluated(unsigned int firstRow, unsigned int firstColumn, unsigned int lastRow, unsigned int lastColumn) const;
+    void classifyRectangle(unsigned int firstRow, unsigned int firstColumn, unsigned int lastRow, unsigned int lastColumn, unsigned int iterations, const Power &power, unsigned long int *iterated);
+
+public:
+    long double minReal;
+    long double minImag;
+    long double spacing;
+
+    unsigned int rows;    // along the real axis
+    unsigned int columns; // along the imaginary axis
+
+    bool symmetric;
+    long int mirrorSum;  // column + the column of its conjugate
+    long int axisColumn; // column lying on the real axis, or -1 if there is none
+
+    unsigned int shardIndex;
+    unsigned int shardCount;
+
+    unsigned int tileSize;
+    unsigned int tileRows;
+    unsigned int tileColumns;
+
+    SeedGrid(const RenderConfig &config);
+
+    inline ComplexNumber seed(unsigned int row, unsigned int column) const {
+        // seeds on the axis are placed exactly on it, so that their orbits are exactly real
+        if ((long int)column == axisColumn)
+            return ComplexNumber(minReal + spacing * row, 0);
+
+        return ComplexNumber(minReal + spacing * row, minImag + spacing * column);
+    };
+
+    inline unsigned long int index(unsigned int row, unsigned int column) const { return (unsigned long int)row * columns + column; };
+
+    inline bool active(unsigned int row, unsigned int column) const { return activeTiles[(row / tileSize) * tileColumns + column / tileSize]; };
+
+    inline SeedKind kind(unsigned int row, unsigned int column) const {
+        long int mirror = mirrorSum - column;
+
+        if (!symmetric || mirror < 0 || mirror >= (long int)columns)
+            return active(row, column) ? SEED_PLAIN : SEED_SKIPPED;
+
+        if (mirror > (long int)column)
+            return SEED_SKIPPED;
+        if (mirror == (long int)column)
+            return active(row, column) ? SEED_AXIS : SEED_SKIPPED;
+
+        // culling is not exactly symmetric, so a pair is kept if either of its seeds is
+        return active(row, column) || active(row, mirror) ? SEED_MIRRORED : SEED_SKIPPED;
+    };
+
+    // whether the tile that c falls in survived culling, for seeds drawn from anywhere in the domain rather than
+    // from the grid. With symmetry, c stands in for its conjugate, so is also kept by the conjugate's tile
+    bool activeAt(const ComplexNumber &c) const;
+
+    inline SeedClass classification(unsigned int row, unsigned int column) const { return classes.empty() ? SEED_UNCLASSIFIED : (SeedClass)classes[index(row, column)]; };
+
+    // whether the row belongs to this shard and has any seed left after culling
+    bool rowActive(unsigned int row) const;
+
+    unsigned long int count() const { return (unsigned long int)rows * columns; };
+    unsigned long int activeCount() const;
+
+    // number of orbits that will actually be evaluated, after culling and symmetry
+    unsigned long int evaluatedCount() const;
+
+    // coarse pre-pass, switching off every tile where none of the sampled contributing orbits land in the
+    // viewport, or the viewport of any neighbouring tile, as a margin for thin features that fall between samples
+    void cull(const Histogram *histogram, const RenderConfig &config);
+
+    // whether culling is asked for and could drop any seeds. Projected views see the orbits from elsewhere, so have
+    // to keep every seed, as does a viewport covering the whole seed domain
+    bool cullable(const Histogram *histogram, const RenderConfig &config) const;
+
+    // blocks of INTERIOR_BLOCK_SIZE seeds per side that the interior pre-pass starts from, numbered row by row
+    unsigned int blockRows() const { return (rows + INTERIOR_BLOCK_SIZE - 1) / INTERIOR_BLOCK_SIZE; };
+    unsigned int blockColumns() const { return (columns + INTERIOR_BLOCK_SIZE - 1) / INTERIOR_BLOCK_SIZE; };
+
+    // the seeds of the block, the last ones included, clipped to the grid
+    void blockBounds(unsigned long int block, unsigned int *firstRow, unsigned int *firstColumn, unsigned int *lastRow, unsigned int *lastColumn) const;
+
+    // whether any seed of the block is evaluated
+    bool blockEvaluated(unsigned long int block) const;
+
+    // Mariani-Silver pre-pass, iterating the borders of ever smaller rectangles of seeds, starting from blocks of
+    // INTERIOR_BLOCK_SIZE. The seeds within a border that is entirely bounded are bounded too, as the seeds that
+    // stay bounded for a whole degree's polynomial have no holes, so are classified without being iterated.
+    // Returns the number of seeds classified, with the number of those that had to be iterated in iterated
+    unsigned long int classifyInterior(const RenderConfig &config, unsigned long int *iterated);
+
+    // the pre-pass over only the given blocks, leaving the seeds of every other block unclassified
+    unsigned long int classifyBlocks(const RenderConfig &config, const std::vector<unsigned long int> &blocks, unsigned long int *iterated);
+};
+
+#endif // SeedGrid_hpp
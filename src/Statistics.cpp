@@ -0,0 +1,58 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Statistics.hpp"
+
+#include <chrono>
+
+void ThreadCounters::add(const ThreadCounters &other) {
+    orbitsEvaluated += other.orbitsEvaluated;
+    iterationsExecuted += other.iterationsExecuted;
+    contributingSeeds += other.contributingSeeds;
+    histogramIncrements += other.histogramIncrements;
+    cyclesFound += other.cyclesFound;
+    busySeconds += other.busySeconds;
+}
+
+double Statistics::now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Statistics::addPhase(const std::string &name, double seconds) {
+    for (std::pair<std::string, double> &p : phases) {
+        if (p.first == name) {
+            p.second += seconds;
+            return;
+        }
+    }
+
+    phases.push_back({ name, seconds });
+}
+
+double Statistics::phase(const std::string &name) const {
+    for (const std::pair<std::string, double> &p : phases) {
+        if (p.first == name)
+            return p.second;
+    }
+
+    return 0.0;
+}
+
+void Statistics::aggregate() {
+    ThreadCounters summed;
+
+    for (const ThreadCounters &t : threads)
+        summed.add(t);
+
+    // the OpenCL path fills in the totals directly, as it has no worker threads
+    if (!threads.empty())
+        total = summed;
+
+    wallSeconds = now() - startTime;
+}
@@ -0,0 +1,73 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef Statistics_hpp
+#define Statistics_hpp
+
+// counters owned by a single worker thread, only summed once the workers have joined so the hot path never
+// touches shared memory
+struct ThreadCounters {
+    unsigned long long orbitsEvaluated;
+    unsigned long long iterationsExecuted;
+    unsigned long long contributingSeeds;
+    unsigned long long histogramIncrements;
+    unsigned long long cyclesFound; // orbits cut short by settling into a cycle
+
+    double busySeconds;
+
+    char padding[64]; // keeps neighbouring threads' counters off of the same cache line
+
+    ThreadCounters() : orbitsEvaluated(0), iterationsExecuted(0), contributingSeeds(0), histogramIncrements(0), cyclesFound(0), busySeconds(0) {};
+
+    void add(const ThreadCounters &other);
+};
+
+class Statistics {
+public:
+    std::string backend;
+
+    std::vector<std::pair<std::string, double>> phases;
+    std::vector<ThreadCounters> threads;
+
+    ThreadCounters total;
+    unsigned long long kernelLaunches;
+
+    // the OpenCL kernels do not report how many iterations each work-item ran, nor which orbits settled into cycles
+    bool iterationsTracked;
+
+    double startTime;
+    double wallSeconds;
+
+    Statistics() : backend("cpu"), kernelLaunches(0), iterationsTracked(true), startTime(now()), wallSeconds(0) {};
+
+    static double now();
+
+    void addPhase(const std::string &name, double seconds);
+    double phase(const std::string &name) const;
+
+    void aggregate();
+};
+
+// adds the time between construction and destruction to the named phase
+class PhaseTimer {
+private:
+    Statistics *stats;
+    std::string name;
+    double start;
+
+public:
+    PhaseTimer(Statistics *stats, std::string name) : stats(stats), name(name), start(Statistics::now()) {};
+    ~PhaseTimer() { stats->addPhase(name, Statistics::now() - start); };
+};
+
+#endif // Statistics_hpp
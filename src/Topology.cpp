@@ -0,0 +1,200 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Topology.hpp"
+
+#ifdef __linux__
+    #include <dirent.h>
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+// parses a sysfs cpu list, e.g "0-3,8,10-11"
+static std::vector<unsigned int> parseCpuList(const std::string &list) {
+    std::vector<unsigned int> cpus;
+
+    std::stringstream listStream(list);
+    std::string range;
+
+    while (std::getline(listStream, range, ',')) {
+        unsigned int first, last;
+        int matched = sscanf(range.c_str(), "%u-%u", &first, &last);
+
+        if (matched == 1)
+            last = first;
+        else if (matched != 2 || last < first)
+            continue;
+
+        for (unsigned int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+
+    return cpus;
+}
+
+// the reverse of the above, for printing
+static std::string formatCpuList(const std::vector<unsigned int> &cpus) {
+    std::string list;
+
+    for (unsigned int i = 0; i < cpus.size();) {
+        unsigned int j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+            ++j;
+
+        if (!list.empty())
+            list += ',';
+
+        list += std::to_string(cpus[i]);
+        if (j != i)
+            list += '-' + std::to_string(cpus[j]);
+
+        i = j + 1;
+    }
+
+    return list;
+}
+
+Topology Topology::detect(const std::string &root) {
+    Topology topology;
+
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool restricted = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    DIR *directory = opendir(root.c_str());
+
+    if (directory) {
+        struct dirent *entry;
+
+        while ((entry = readdir(directory)) != NULL) {
+            unsigned int id;
+            char trailing;
+
+            if (sscanf(entry->d_name, "node%u%c", &id, &trailing) != 1)
+                continue;
+
+            std::ifstream cpuList(root + '/' + entry->d_name + "/cpulist");
+            std::string line;
+
+            if (!std::getline(cpuList, line))
+                continue;
+
+            NumaNode node;
+            node.id = id;
+
+            // cpus outside of the process' affinity mask, e.g from taskset or a cgroup, cannot be pinned to
+            for (unsigned int cpu : parseCpuList(line)) {
+                if (!restricted || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)))
+                    node.cpus.push_back(cpu);
+            }
+
+            // memory-only nodes have no cpus to run workers on
+            if (!node.cpus.empty())
+                topology.nodes.push_back(node);
+        }
+
+        closedir(directory);
+    }
+
+    std::sort(topology.nodes.begin(), topology.nodes.end(), [](const NumaNode &a, const NumaNode &b) { return a.id < b.id; });
+
+    topology.pinnable = !topology.nodes.empty();
+#else
+    (void)root;
+#endif
+
+    if (topology.nodes.empty()) {
+        NumaNode node;
+        node.id = 0;
+
+        unsigned int cpus = std::max(std::thread::hardware_concurrency(), 1u);
+        for (unsigned int cpu = 0; cpu < cpus; ++cpu)
+            node.cpus.push_back(cpu);
+
+        topology.nodes.push_back(node);
+    }
+
+    return topology;
+}
+
+unsigned int Topology::place(unsigned int threadId, unsigned int *cpu) const {
+    const unsigned int nodeIndex = threadId % nodes.size();
+    const NumaNode &node = nodes[nodeIndex];
+
+    *cpu = node.cpus[(threadId / nodes.size()) % node.cpus.size()];
+
+    return nodeIndex;
+}
+
+int Topology::pin(unsigned int cpu) {
+#ifdef __linux__
+    if (cpu >= CPU_SETSIZE)
+        return 1;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? 0 : 1;
+#else
+    (void)cpu;
+    return 1;
+#endif
+}
+
+unsigned long int Topology::cacheSize(unsigned int level, unsigned long int fallback) {
+#ifdef __linux__
+    // sysfs lists each cache of cpu0 as its own index, with its level, type and size, e.g "2048K"
+    for (unsigned int index = 0; index < 8; ++index) {
+        const std::string directory = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index);
+
+        std::ifstream levelFile(directory + "/level");
+        std::ifstream typeFile(directory + "/type");
+        std::ifstream sizeFile(directory + "/size");
+
+        unsigned int cacheLevel;
+        std::string type, size;
+
+        if (!(levelFile >> cacheLevel) || !(typeFile >> type) || !(sizeFile >> size))
+            break;
+
+        if (cacheLevel != level || type == "Instruction")
+            continue;
+
+        unsigned long int bytes = std::stoul(size);
+
+        if (size.back() == 'K')
+            bytes <<= 10;
+        else if (size.back() == 'M')
+            bytes <<= 20;
+
+        return bytes != 0 ? bytes : fallback;
+    }
+#else
+    (void)level;
+#endif
+
+    return fallback;
+}
+
+std::string Topology::summary() const {
+    std::string result = std::to_string(nodes.size()) + (nodes.size() == 1 ? " node (" : " nodes (");
+
+    for (unsigned int i = 0; i < nodes.size(); ++i)
+        result += (i != 0 ? ", " : "") + std::to_string(nodes[i].id) + ": " + formatCpuList(nodes[i].cpus);
+
+    return result + ")";
+}
@@ -0,0 +1,53 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include <string>
+#include <vector>
+
+#ifndef Topology_hpp
+#define Topology_hpp
+
+// cpus sharing a memory controller
+struct NumaNode {
+    unsigned int id;
+    std::vector<unsigned int> cpus;
+};
+
+// the machine's NUMA nodes, as far as this process is allowed to run on them. Found through sysfs on Linux,
+// elsewhere, or when sysfs is missing, the machine is treated as a single node without pinning
+class Topology {
+private:
+    std::vector<NumaNode> nodes;
+    bool pinnable;
+
+public:
+    Topology() : pinnable(false) {};
+
+    static Topology detect(const std::string &root = "/sys/devices/system/node");
+
+    unsigned int nodeCount() const { return (unsigned int)nodes.size(); };
+    const NumaNode &node(unsigned int index) const { return nodes[index]; };
+
+    bool canPin() const { return pinnable; };
+
+    // spreads threads over the nodes in turn, so that fewer threads than cpus still use every node, returning the
+    // index of the node that thread threadId is placed on and the cpu it should be pinned to
+    unsigned int place(unsigned int threadId, unsigned int *cpu) const;
+
+    // pins the calling thread to a single cpu, returning 0 on success
+    static int pin(unsigned int cpu);
+
+    // bytes of the data or unified cache at level, e.g 2 for L2, or fallback if it cannot be found
+    static unsigned long int cacheSize(unsigned int level, unsigned long int fallback);
+
+    // e.g "2 nodes (0: 0-15, 1: 16-31)"
+    std::string summary() const;
+};
+
+#endif // Topology_hpp
@@ -0,0 +1,19 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "Views.hpp"
+
+Views::Views(Histogram *histogram, std::vector<Histogram> *projected, const std::vector<Projection> &projections) {
+    this->projections.push_back(Projection::identity());
+    this->projections.insert(this->projections.end(), projections.begin(), projections.end());
+
+    histograms.push_back(histogram);
+    for (Histogram &view : *projected)
+        histograms.push_back(&view);
+}
@@ -0,0 +1,80 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "ComplexNumber.hpp"
+#include "Histogram.hpp"
+#include "Projection.hpp"
+
+#include <vector>
+
+#ifndef Views_hpp
+#define Views_hpp
+
+// a worker's handle on the histograms of several projections of the same orbits, the viewport itself being the
+// first of them. Stands in for the histogram in Orbit's escape and bin, which evaluate each orbit once and bin
+// every point of it into every view. Each view needs the point itself rather than the pixel it landed on, so the
+// orbit being evaluated is kept here until it is known to contribute
+class Views {
+private:
+    std::vector<Projection> projections;
+    std::vector<Histogram*> histograms;
+
+    std::vector<ComplexNumber> points;
+
+public:
+    // projected holds one histogram per projection, covering the same viewport as histogram
+    Views(Histogram *histogram, std::vector<Histogram> *projected, const std::vector<Projection> &projections);
+
+    std::vector<ComplexNumber> *orbit() { return &points; };
+
+    // bins amount of the point z of the orbit of c into every view, and of its conjugate when mirrored. Returns
+    // how many increments landed inside of the views
+    inline unsigned long int bin(const ComplexNumber &z, const ComplexNumber &c, unsigned int amount, bool mirrored) {
+        unsigned long int increments = 0;
+
+        for (unsigned int v = 0; v < histograms.size(); ++v) {
+            const Projection &projection = projections[v];
+            Histogram *histogram = histograms[v];
+
+            long double real, imag;
+            projection.apply(z, c, &real, &imag);
+
+            unsigned long int index, mirror;
+
+            if (mirrored && projection.separable()) {
+                if (histogram->index(real, imag, &index, &mirror)) {
+                    histogram->add(index, amount);
+                    histogram->add(mirror, amount);
+                    increments += 2 * (unsigned long int)amount;
+                }
+
+                continue;
+            }
+
+            if (histogram->index(real, imag, &index)) {
+                histogram->add(index, amount);
+                increments += amount;
+            }
+
+            // the conjugate orbit has to be projected for itself when the view mixes the real and imaginary parts
+            if (mirrored) {
+                projection.apply(ComplexNumber(z.real, -z.imag), ComplexNumber(c.real, -c.imag), &real, &imag);
+
+                if (histogram->index(real, imag, &index)) {
+                    histogram->add(index, amount);
+                    increments += amount;
+                }
+            }
+        }
+
+        return increments;
+    };
+};
+
+#endif // Views_hpp
@@ -12,11 +12,13 @@
 #include <windows.h>
 #endif
 
-#include "Cell.hpp"
-#include "OpenCLKernelHelper.hpp"
+#include "BatchRunner.hpp"
+#include "Estimator.hpp"
+#include "Options.hpp"
+#include "RenderServer.hpp"
+#include "Renderer.hpp"
 // #include "CUDAKernelHelper.hpp"
-#include "io/PNGWriter.hpp"
-#include "io/CSVReader.hpp"
+#include "io/JSONWriter.hpp"
 
 #if USE_OPENGL
 #ifdef __APPLE__
@@ -36,193 +38,75 @@
 #include <thread>
 #include <vector>
 
-static const long double GL_CANVAS_MIN_X = -1.0;
-static const long double GL_CANVAS_MAX_X = 1.0;
-static const long double GL_CANVAS_MIN_Y = -1.0;
-//static const long double GL_CANVAS_MAX_Y = 1.0;
-static const long double REAL_DIFF = 3.5;
-static const std::pair<long double, long double> MIN = { -2.5, -1.75 };
-//static const std::pair<long double, long double> MAX = { MIN.first + REAL_DIFF, MIN.second + REAL_DIFF };
-static const std::pair<long double, long double> IMAGE_MIN = { GL_CANVAS_MIN_X, GL_CANVAS_MIN_Y };
-
 #if USE_OPENGL
+static const long double GL_CANVAS_MIN = -1.0;
+static const long double GL_CANVAS_MAX = 1.0;
+
 static void displayCallback();
 #endif
-static void showUsage(std::string name);
-static void executeRowsEscapes(unsigned int threadId, unsigned int threadsTotal);
-
-static unsigned int iterations = 500;
-static unsigned int iterationsMax = 0;
-static unsigned int windowWidth = 501;
-static unsigned char numThreads = std::thread::hardware_concurrency() != 0 ? std::thread::hardware_concurrency() : 4;
-static unsigned char colourR = 0;
-static unsigned char colourG = 0;
-static unsigned char colourB = 255;
-static bool anti = false;
-static bool load = false;
-static bool alpha = false;
-static bool useGpu = false;
-
-static std::string loadFileName;
-#if USE_OPENGL
-static bool save = false;
-static std::string saveFileName;
-#else
-static bool save = true;
-static std::string saveFileName = "buddhabrot";
-#endif
 
-static std::vector<std::vector<Cell*>> g_cellsClass = {};
-static Real* g_cellsGPU;
-static unsigned int g_maxCount = 0;
+static RenderConfig config;
+static Renderer *g_renderer = NULL;
 
 int main(int argc, char* argv[]) {
     // parse arguments
     if (argc < 2)
         showUsage(argv[0]);
 
-    // put ':' at the starting of the string so compiler can distinguish between '?' and ':'
-    std::string tmp;
-    std::stringstream lineStream;
-
-    for (int i = 1; i < argc; ++i) {
-        switch(argv[i][1]) {
-            case 'a' :
-                anti = true;
-                break;
-
-            case 's' :
-                save = true;
-                saveFileName = std::string(argv[++i]);
-                break;
-
-            case 'l' :
-                load = true;
-                loadFileName = std::string(argv[++i]);
-                useGpu = true;
-                break;
-
-            case '4' :
-                alpha = true;
-                break;
-
-            case 'o' :
-                useGpu = true;
-                break;
-
-            case 'w' :
-                windowWidth = std::stoi(argv[++i]);
-                break;
-
-            case 'i' :
-                iterations = std::stoi(argv[++i]);
-                break;
-
-            case 'm' :
-                iterationsMax = std::stoi(argv[++i]);
-                break;
-
-            case 'c' :
-                lineStream = std::stringstream(std::string(argv[++i]));
-
-                std::getline(lineStream, tmp, ',');
-                colourR = (unsigned char)std::stoi(tmp);
-
-                std::getline(lineStream, tmp, ',');
-                colourG = (unsigned char)std::stoi(tmp);
-
-                std::getline(lineStream, tmp, ',');
-                colourB = (unsigned char)std::stoi(tmp);
-                break;
-
-            case 't' :
-                numThreads = (unsigned char)std::stoi(argv[++i]);
-                break;
-
-            case 'h' :
-                showUsage(argv[0]);
-                return -1;
-                break;
-
-            default :
-                printf("Unknown option: %s\n", argv[i]);
-                showUsage(argv[0]);
-                break;
-        }
-    }
-
-    // print what buddhabrot will be generated
-    std::string saveLoc = save ? saveFileName.c_str() : "N/A";
-    std::cout << std::endl << std::string(load ? "Loading " : "Generating ") + std::string(anti ? "anti-" : "") + "buddhabrot with arguments :" << std::endl;
-    printf("\twindow size\t\t %d x %d\n", windowWidth, windowWidth);
-    printf("\titerations\t\t %d\n", iterations);
-    printf("\tgenerate with GPU\t %s\n", useGpu ? "true" : "false");
-    printf("\tthreads\t\t\t %s\n", useGpu ? "N/A" : std::to_string(numThreads).c_str());
-    printf("\tcolour\t\t\t (%d, %d, %d)\n", colourR, colourG, colourB);
-    printf("\tsave to\t\t\t %s.png and %s.csv\n", saveLoc.c_str(), saveLoc.c_str());
-    printf("\tpng with alpha\t\t %s\n", save ? alpha ? "true" : "false" : "N/A");
-
-    std::cout << std::endl;
-
-    // calculate buddhabrot
-    long double cellImageWidth = (GL_CANVAS_MAX_X - GL_CANVAS_MIN_X) / double(windowWidth);
-    long double cellRealWidth = REAL_DIFF / windowWidth;
+    Options options;
 
-    if (load) {
-        CSVReader csv((char*)loadFileName.c_str(), windowWidth);
-        g_cellsGPU = csv.read();
-
-        for (unsigned int i = 0; i < windowWidth; ++i) {
-            for (unsigned int j = 0; j < windowWidth; ++j)
-                g_maxCount = std::max(g_maxCount, (unsigned int)g_cellsGPU[i * windowWidth * 3 + j * 3 + 2]);
-        }
-
-        std::cout << "Loaded fractal" << std::endl;
-    } else {
-        if (useGpu)
-            calculateCells(&g_cellsGPU, &g_maxCount, &iterations, &windowWidth, &MIN, &cellRealWidth, &anti, &iterationsMax);
-        else {
-            std::vector<Cell*> holding;
+    // nothing is rendered from options that failed to parse, so that scripts can tell
+    int err = parseOptions(std::vector<std::string>(argv + 1, argv + argc), &options);
+    if (err != 0) {
+        showUsage(argv[0]);
+        return err == -1 ? -1 : 1;
+    }
 
-            for (unsigned int i = 0; i < windowWidth; ++i) {
-                holding.clear();
-                for (unsigned int j = 0; j < windowWidth; ++j) {
-                    long double realx = MIN.first + cellRealWidth * (windowWidth - 1 - i); // inverting iteration through cells on the x-axis so that the buddhabrot renders "sitting-down" -- more picturesque
-                    long double realy = MIN.second + cellRealWidth * j;
-                    holding.push_back(new Cell(realx, realy, cellRealWidth, cellImageWidth, &MIN, &IMAGE_MIN));
-                }
+    if (options.batch) {
+        BatchRunner batch(options.batchFileName);
+        return batch.run();
+    }
 
-                g_cellsClass.push_back(holding);
-            }
+    if (options.serve) {
+        RenderServer server(options.serveSocketName);
+        return server.run();
+    }
 
-            g_cellsClass.shrink_to_fit();
+    config = options.config;
 
-            std::cout << "Memory successfully yoinked" << std::endl;
+    // print what buddhabrot will be generated
+    printOptions(options);
 
-            std::vector<std::thread*> threads;
+    if (options.estimate) {
+        Estimator estimator(config);
+        Estimate estimate;
 
-            for (unsigned int i = 0; i < (numThreads - 1); ++i)
-                threads.push_back(new std::thread(executeRowsEscapes, i, numThreads));
+        if (estimator.run(&estimate) != 0)
+            return 1;
 
-            executeRowsEscapes(numThreads, numThreads);
+        printEstimate(estimate, config);
+        return 0;
+    }
 
-            for (unsigned int i = 0; i < threads.size(); ++i) {
-                threads[i]->join();
-                delete threads[i];
-                threads.erase(threads.begin() + i);
-            }
-        }
+    // calculate buddhabrot
+    Renderer renderer(config);
+    g_renderer = &renderer;
 
-        std::cout << "Calculated fractal" << std::endl;
+    if (options.load) {
+        if (renderer.load(options.loadFileName) != 0)
+            return 1;
+    } else {
+        if (renderer.render() != 0)
+            return 1;
     }
 
-    std::cout << "Max count := " << g_maxCount << std::endl;
+    std::cout << "Max count := " << renderer.getMaxCount() << std::endl;
 
     // display buddhabrot
 #if USE_OPENGL
-    if (!save) {
+    if (!options.save) {
         glutInit(&argc, argv);
-        glutInitWindowSize(windowWidth, windowWidth);
+        glutInitWindowSize(config.windowWidth, config.height());
         glutInitDisplayMode(GLUT_RGBA);
         glutCreateWindow("Buddhabrot");
 
@@ -236,89 +120,43 @@ int main(int argc, char* argv[]) {
         glutMainLoop();
     } else {
 #endif
-        PNGWriter picture(saveFileName + ".png", windowWidth, windowWidth, colourR, colourG, colourB, g_maxCount, alpha);
-        CSVReader csv(saveFileName + ".csv", windowWidth);
-
-        if (useGpu) {
-            picture.write(g_cellsGPU);
-            csv.write(g_cellsGPU);
-        } else {
-            picture.write(&g_cellsClass);
-            csv.write(&g_cellsClass);
-        }
+        err = renderer.save(options.saveFileName);
 #if USE_OPENGL
     }
 #endif
 
-    return 0;
+    if (options.stats) {
+        JSONWriter json(options.statsFileName);
+        if (json.write(renderer.getStatistics()) != 0)
+            std::cout << "Failed to save statistics to " << options.statsFileName << std::endl;
+    }
+
+    return err == 0 ? 0 : 1;
 }
 
 #if USE_OPENGL
 static void displayCallback() {
     glClear(GL_COLOR_BUFFER_BIT);
 
-    if (useGpu) {
-        long double cellRealWidth = REAL_DIFF / windowWidth;
-        long double cellImageWidth = (GL_CANVAS_MAX_X - GL_CANVAS_MIN_X) / double(windowWidth);
+    const Histogram &histogram = g_renderer->getHistogram();
+    const unsigned int maxCount = g_renderer->getMaxCount();
 
-        for (unsigned int i = 0; i < windowWidth; ++i) {
-            for (unsigned int j = 0; j < windowWidth; ++j) {
-                long double imagex = abs(((MIN.first - g_cellsGPU[i * windowWidth * 3 + j * 3 + 0]) / cellRealWidth) * cellImageWidth) + IMAGE_MIN.first;
-                long double imagey = abs(((MIN.second - g_cellsGPU[i * windowWidth * 3 + j * 3 + 1]) / cellRealWidth) * cellImageWidth) + IMAGE_MIN.second;
+    // the canvas spans -1 to 1 both ways, histogram rows running down the window like the rows of the png
+    long double pixelWidth = (GL_CANVAS_MAX - GL_CANVAS_MIN) / double(histogram.width);
+    long double pixelHeight = (GL_CANVAS_MAX - GL_CANVAS_MIN) / double(histogram.height);
 
-                long double percentageOfMax = log(g_cellsGPU[i * windowWidth * 3 + j * 3 + 2]) / log(g_maxCount);
-                long double brightness = percentageOfMax > 0.25 ? percentageOfMax : 0.0;
-                glColor4f(colourR / 255.0f, colourG / 255.0f, colourB / 255.0f, brightness);
-                glRectd(imagey, imagex, imagey + cellImageWidth, imagex + cellImageWidth); // x and y flipped to render it vertically
-            }
-        }
-    } else {
-        for (std::vector<Cell*> h : g_cellsClass) {
-            for (Cell* cell : h)
-                cell->render(g_maxCount, colourR, colourG, colourB);
+    for (unsigned int i = 0; i < histogram.height; ++i) {
+        for (unsigned int j = 0; j < histogram.width; ++j) {
+            long double imagex = GL_CANVAS_MIN + j * pixelWidth;
+            long double imagey = GL_CANVAS_MAX - (i + 1) * pixelHeight;
+
+            long double percentageOfMax = log(histogram.get(i, j)) / log(maxCount);
+            long double brightness = percentageOfMax > 0.25 ? percentageOfMax : 0.0;
+            glColor4f(config.colourR / 255.0f, config.colourG / 255.0f, config.colourB / 255.0f, brightness);
+            glRectd(imagex, imagey, imagex + pixelWidth, imagey + pixelHeight);
         }
     }
 
     glFlush();
 }
 #endif
-
-static void showUsage(std::string name) {
-    std::cerr << "Usage: " << name << " <option(s)>\n"
-        << "Options:\n"
-        << "\t-h\n\t\t Show this help message\n\n"
-        << "\t-a\n\t\t Generate an anti-buddhabrot\n\t\t defaults to false\n\n"
-        << "\t-o\n\t\t Calculate the buddhabrot using OpenCL, i.e using GPU\n\t\t defaults to false\n\n"
-        << "\t-4\n\t\t Generate png with alpha based-brightness; viewer dependant\n\t\t defaults to false\n\n"
-#if USE_OPENGL
-        << "\t-s FILE_NAME\n\t\t Saves buddhabrot as a png and csv to the specified\n\t\t (FILE_NAME + '.png'/'.csv')\n\t\t defaults to not save\n\n"
-#else
-        << "\t-s FILE_NAME\n\t\t Saves buddhabrot as a png and csv to the specified\n\t\t (FILE_NAME + '.png'/'.csv')\n\t\t defaults to 'buddhabrot'\n\n"
-#endif
-        << "\t-l FILE_NAME\n\t\t Loads buddhabrot from specified plaintext file. If correct -p\n\t\t not known, sqrt(lines in FILE_NAME - 1)\n\t\t defaults to not load\n\n"
-        << "\t-w WINDOW_WIDTH\n\t\t Specify the width and pixels of the window and buddhabrot\n\t\t defaults to 501\n\n"
-        << "\t-i ITERATIONS\n\t\t Specify the number of iterations to be performed on each point\n\t\t defaults to 500\n\n"
-        << "\t-m ITERATIONS_MAX\n\t\t Specify the number of iterations per group to be ran by the\n\t\t GPU. Important as prevents hanging GPU for larger ITERATIONS\n\t\t values. WINDOW_WIDTH is the largest influence of how large the\n\t\t ITERATION_MAX value can be. e.g 2001 can run at around 50000\n\t\t per group and 4501 at around 10000\n\t\t defaults to use estimation for maximum\n\n"
-        << "\t-c COLOUR_R,COLOUR_G,COLOUR_B\n\t\t Specify the render's colour\n\t\t defaults to 0,0,255\n\n"
-        << "\t-t NUM_THREADS\n\t\t Specify the number of threads to be used to compute the fractal\n\t\t defaults to the number of findable threads or 4\n"
-        << std::endl;
-}
-
-static void executeRowsEscapes(unsigned int threadId, unsigned int threadsTotal) {
-    unsigned int groups = windowWidth / threadsTotal;
-    for (unsigned int i = 0; i < groups; ++i) {
-        unsigned int currentColumn = i * threadsTotal + threadId;
-
-        if (windowWidth > currentColumn) {
-            std::vector<Cell*> h = g_cellsClass[currentColumn];
-            for (Cell* cell : h)
-                Cell::escape(&cell->complex, &g_cellsClass, &MIN, iterations, windowWidth, &g_maxCount, anti);
-        }
-    }
-
-    if (windowWidth > groups * threadsTotal + threadId) {
-        std::vector<Cell*> h = g_cellsClass[groups * threadsTotal + threadId];
-        for (Cell* cell : h)
-            Cell::escape(&cell->complex, &g_cellsClass, &MIN, iterations, windowWidth, &g_maxCount, anti);
-    }
-}
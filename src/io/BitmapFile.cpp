@@ -0,0 +1,124 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "BitmapFile.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+static const char BITMAP_MAGIC[4] = { 'B', 'B', 'R', 'L' };
+static const uint32_t BITMAP_VERSION = 1;
+
+int BitmapFile::read(std::vector<unsigned char> *values, unsigned int bitmaps) {
+    std::ifstream stream;
+    stream.open(fname, std::ios::binary);
+
+    if (!stream)
+        return 1;
+
+    char magic[4];
+    uint32_t version, bitmapCount;
+    uint64_t size;
+
+    stream.read(magic, sizeof(magic));
+    stream.read((char*)&version, sizeof(version));
+    stream.read((char*)&bitmapCount, sizeof(bitmapCount));
+    stream.read((char*)&size, sizeof(size));
+
+    if (!stream || std::string(magic, 4) != std::string(BITMAP_MAGIC, 4) || version != BITMAP_VERSION || bitmapCount != bitmaps || size != values->size())
+        return 1;
+
+    std::vector<unsigned char> result(values->size(), 0);
+
+    for (unsigned int b = 0; b < bitmaps; ++b) {
+        uint64_t runs;
+        stream.read((char*)&runs, sizeof(runs));
+
+        // runs alternate between unset and set bits, starting with unset
+        uint64_t position = 0;
+
+        for (uint64_t r = 0; r < runs && stream; ++r) {
+            uint64_t length;
+            stream.read((char*)&length, sizeof(length));
+
+            if (position + length > size)
+                return 1;
+
+            if (r % 2 == 1) {
+                for (uint64_t i = position; i < position + length; ++i)
+                    result[i] |= (unsigned char)(1 << b);
+            }
+
+            position += length;
+        }
+
+        if (!stream || position != size)
+            return 1;
+    }
+
+    values->swap(result);
+
+    return 0;
+}
+
+int BitmapFile::write(const std::vector<unsigned char> &values, unsigned int bitmaps) {
+    // written next to the destination and then moved over it, so readers never see half of a file
+    std::string temporary = fname + ".tmp";
+
+    std::ofstream stream;
+    stream.open(temporary, std::ios::binary);
+
+    if (!stream)
+        return 1;
+
+    uint32_t bitmapCount = bitmaps;
+    uint64_t size = values.size();
+
+    stream.write(BITMAP_MAGIC, sizeof(BITMAP_MAGIC));
+    stream.write((const char*)&BITMAP_VERSION, sizeof(BITMAP_VERSION));
+    stream.write((const char*)&bitmapCount, sizeof(bitmapCount));
+    stream.write((const char*)&size, sizeof(size));
+
+    std::vector<uint64_t> runs;
+
+    for (unsigned int b = 0; b < bitmaps; ++b) {
+        runs.clear();
+
+        bool current = false;
+        uint64_t length = 0;
+
+        for (unsigned char value : values) {
+            bool set = (value >> b) & 1;
+
+            if (set != current) {
+                runs.push_back(length);
+                current = set;
+                length = 0;
+            }
+
+            ++length;
+        }
+
+        runs.push_back(length);
+
+        uint64_t runCount = runs.size();
+        stream.write((const char*)&runCount, sizeof(runCount));
+        stream.write((const char*)runs.data(), sizeof(uint64_t) * runs.size());
+    }
+
+    stream.close();
+
+    if (!stream || std::rename(temporary.c_str(), fname.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return 1;
+    }
+
+    return 0;
+}
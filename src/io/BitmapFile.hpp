@@ -0,0 +1,30 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include <string>
+#include <vector>
+
+#ifndef BitmapFile_hpp
+#define BitmapFile_hpp
+
+// stores a number of bitmaps, one per bit of each element of values, run-length encoded as they are mostly made
+// of long runs, e.g the seeds inside of the mandelbrot set
+class BitmapFile {
+private:
+    std::string fname;
+
+public:
+    BitmapFile(std::string fname) : fname(fname) {};
+
+    // fails if the file does not exist or holds a different number of values or bitmaps
+    int read(std::vector<unsigned char> *values, unsigned int bitmaps);
+    int write(const std::vector<unsigned char> &values, unsigned int bitmaps);
+};
+
+#endif // BitmapFile_hpp
@@ -1,6 +1,6 @@
 //===========================================================================//
 ///
-/// Copyright Jim Carty © 2020
+/// Copyright Jim Carty © 2020-2021
 ///
 /// This file is subject to the terms and conditions defined in file
 /// 'LICENSE.txt', which is part of this source code package.
@@ -15,92 +15,55 @@
 #include <sstream>
 #include <string>
 
-Real *CSVReader::read() {
+int CSVReader::read(Histogram *histogram) {
     std::ifstream file;
     file.open(fname);
+
+    if (!file)
+        return 1;
     
     std::string line, tmp;
 
     std::getline(file, line, '\n'); // remove headings
     
-    unsigned int lineCount = 0;
+    unsigned long int lineCount = 0;
     
     while (std::getline(file, line, '\n'))
         ++lineCount;
-    
-    cellsPerRow = sqrt(lineCount);
-    
-    Real *result = new Real[cellsPerRow * cellsPerRow * 3];
+
+    if (lineCount != histogram->size()) {
+        unsigned int cellsPerRow = sqrt(lineCount);
+
+        histogram->allocate(cellsPerRow, cellsPerRow, histogram->minReal, histogram->minImag, histogram->cellWidth);
+    }
     
     file.clear();
     file.seekg(0);
     
-    unsigned int count = 0;
+    unsigned long int count = 0;
     
     std::getline(file, line, '\n'); // remove headings
     
-    while (count < cellsPerRow * cellsPerRow && std::getline(file, line, '\n')) {
+    while (count < histogram->size() && std::getline(file, line, '\n')) {
         std::stringstream lineStream(line);
         
-        unsigned int x = count / cellsPerRow;
-        unsigned int y = count % cellsPerRow;
-        
-        // real
+        // real and imag, the position is implied by the order of the lines
         std::getline(lineStream, tmp, ',');
-        result[x * cellsPerRow * 3 + y * 3 + 0] = std::stold(tmp);
-        
-        // imag
         std::getline(lineStream, tmp, ',');
-        result[x * cellsPerRow * 3 + y * 3 + 1] = std::stold(tmp);
         
         // counter
         std::getline(lineStream, tmp, ',');
-        result[x * cellsPerRow * 3 + y * 3 + 2] = std::stold(tmp);
+        histogram->set(count, (unsigned int)std::stoul(tmp));
         
         ++count;
     }
 
     file.close();
     
-    return result;
-}
-
-int CSVReader::write(std::vector<std::vector<Cell*>> *fileData) {
-    std::ofstream stream;
-    
-    stream.open(fname);
-    
-    if (!stream)
-        return 1;
-    
-    std::string resultString = "pixel_real,pixel_imag,counter\n";
-    
-    for (unsigned int i = 0; i < fileData->size(); ++i) {
-        for (unsigned int j = 0; j < fileData->at(i).size(); ++j) {
-            resultString.append(
-                                std::to_string(fileData->at(i)[j]->complex.real) + ',' +
-                                std::to_string(fileData->at(i)[j]->complex.imag) + ',' +
-                                std::to_string((unsigned int)fileData->at(i)[j]->counter) + '\n');
-        }
-        
-        if (i == cellsPerRow / 2) {
-            // write and reset to make sure memory doesnt get higher than initial memory steal
-            stream << resultString;
-            
-            resultString.clear();
-        }
-    }
-    
-    stream << resultString;
-    
-    stream.close();
-    
-    std::cout << "Saved fractal data to " << fname << std::endl;
-    
     return 0;
 }
 
-int CSVReader::write(Real *fileData) {
+int CSVReader::write(const Histogram *histogram) {
     std::ofstream stream;
     
     stream.open(fname);
@@ -108,32 +71,30 @@ int CSVReader::write(Real *fileData) {
     if (!stream)
         return 1;
     
-    std::string resultString = "pixel_real,pixel_imag,counter\n";
+    stream << "pixel_real,pixel_imag,counter\n";
     
-    for (unsigned int i = 0; i < cellsPerRow; ++i) {
-        for (unsigned int j = 0; j < cellsPerRow; ++j)
-            resultString.append(
-                                std::to_string(fileData[i * cellsPerRow * 3 + j * 3 + 0]) + ',' +
-                                std::to_string(fileData[i * cellsPerRow * 3 + j * 3 + 1]) + ',' +
-                                std::to_string((unsigned int)fileData[i * cellsPerRow * 3 + j * 3 + 2]) + '\n');
+    // written a tile at a time so that neither the text nor a file-backed histogram has to fit in memory
+    for (unsigned int tile = 0; tile < histogram->tileCount(); ++tile) {
+        const unsigned int firstRow = histogram->tileFirstRow(tile);
         
-        if (i == cellsPerRow / 2) {
-            // write and reset to make sure memory doesnt get higher than initial memory steal
-            stream << resultString;
+        for (unsigned int i = firstRow; i < firstRow + histogram->tileRowCount(tile); ++i) {
+            std::string rowString;
             
-            resultString.clear();
+            for (unsigned int j = 0; j < histogram->width; ++j)
+                rowString.append(
+                                 std::to_string(histogram->pixelReal(i)) + ',' +
+                                 std::to_string(histogram->pixelImag(j)) + ',' +
+                                 std::to_string(histogram->get(i, j)) + '\n');
             
-            resultString.shrink_to_fit();
+            stream << rowString;
         }
+        
+        histogram->flushRows(firstRow, histogram->tileRowCount(tile));
     }
     
-    stream << resultString;
-    
     stream.close();
     
     std::cout << "Saved fractal data to " << fname << std::endl;
     
     return 0;
 }
-
-
@@ -7,32 +7,24 @@
 ///
 //===========================================================================//
 
-#include "../Cell.hpp"
+#include "../Histogram.hpp"
 
 #include <string>
 
 #ifndef CSVReader_hpp
 #define CSVReader_hpp
 
-#if DOUBLE_SUPPORT_AVAILABLE
-    // double
-    typedef double Real;
-#else
-    // float
-    typedef float Real;
-#endif
-
 class CSVReader {
 private:
     std::string fname;
-    unsigned int cellsPerRow;
     
 public:
-    CSVReader(std::string fname, unsigned int cellsPerRow) : fname(fname), cellsPerRow(cellsPerRow) {};
+    CSVReader(std::string fname) : fname(fname) {};
 
-    Real *read();
-    int write(std::vector<std::vector<Cell*>> *fileData);
-    int write(Real *fileData);
+    // fills in an allocated histogram, falling back to a square histogram when the file does not have a line
+    // for every pixel of it, as with files saved before non-square viewports
+    int read(Histogram *histogram);
+    int write(const Histogram *histogram);
 };
 
 #endif // CSVReader_hpp
@@ -0,0 +1,101 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "HistogramFile.hpp"
+
+#include <cstdint>
+#include <iostream>
+
+static const char HISTOGRAM_MAGIC[4] = { 'B', 'B', 'H', 'G' };
+// 3 since shards were dealt bands of rows rather than single rows, so older shards would not add up with newer ones
+static const uint32_t HISTOGRAM_VERSION = 3;
+
+bool HistogramHeader::sameRender(const HistogramHeader &other) const {
+    return width == other.width && height == other.height &&
+        minReal == other.minReal && minImag == other.minImag && cellWidth == other.cellWidth &&
+        iterations == other.iterations && power == other.power && anti == other.anti && shardCount == other.shardCount;
+}
+
+int HistogramFile::write(const Histogram *histogram, const RenderConfig &config) {
+    std::ofstream stream;
+    stream.open(fname, std::ios::binary);
+
+    if (!stream || write(histogram, config, &stream) != 0)
+        return 1;
+
+    stream.close();
+
+    if (!stream)
+        return 1;
+
+    std::cout << "Saved partial histogram to " << fname << std::endl;
+
+    return 0;
+}
+
+int HistogramFile::write(const Histogram *histogram, const RenderConfig &config, std::ostream *stream) {
+    uint32_t fields[] = { HISTOGRAM_VERSION, histogram->width, histogram->height, config.iterations, (uint32_t)config.anti, config.shardIndex, config.shardCount };
+    double bounds[] = { (double)histogram->minReal, (double)histogram->minImag, (double)histogram->cellWidth, (double)config.power };
+
+    stream->write(HISTOGRAM_MAGIC, sizeof(HISTOGRAM_MAGIC));
+    stream->write((const char*)fields, sizeof(fields));
+    stream->write((const char*)bounds, sizeof(bounds));
+
+    // a row at a time, to not need a second copy of the histogram
+    std::vector<uint32_t> row(histogram->width);
+
+    for (unsigned int i = 0; i < histogram->height && *stream; ++i) {
+        for (unsigned int j = 0; j < histogram->width; ++j)
+            row[j] = histogram->get(i, j);
+
+        stream->write((const char*)row.data(), sizeof(uint32_t) * row.size());
+    }
+
+    return *stream ? 0 : 1;
+}
+
+int HistogramFile::open(HistogramHeader *header) {
+    input.open(fname, std::ios::binary);
+
+    if (!input)
+        return 1;
+
+    char magic[4];
+    uint32_t fields[7];
+    double bounds[4];
+
+    input.read(magic, sizeof(magic));
+    input.read((char*)fields, sizeof(fields));
+    input.read((char*)bounds, sizeof(bounds));
+
+    if (!input || std::string(magic, 4) != std::string(HISTOGRAM_MAGIC, 4) || fields[0] != HISTOGRAM_VERSION)
+        return 1;
+
+    header->width = fields[1];
+    header->height = fields[2];
+    header->iterations = fields[3];
+    header->anti = fields[4];
+    header->shardIndex = fields[5];
+    header->shardCount = fields[6];
+
+    header->minReal = bounds[0];
+    header->minImag = bounds[1];
+    header->cellWidth = bounds[2];
+    header->power = bounds[3];
+
+    return 0;
+}
+
+unsigned long int HistogramFile::readChunk(std::vector<unsigned int> *counts) {
+    static_assert(sizeof(unsigned int) == sizeof(uint32_t), "histogram counts are stored as 32-bit");
+
+    input.read((char*)counts->data(), sizeof(unsigned int) * counts->size());
+
+    return input.gcount() / sizeof(unsigned int);
+}
@@ -0,0 +1,59 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "../Histogram.hpp"
+#include "../RenderConfig.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef HistogramFile_hpp
+#define HistogramFile_hpp
+
+// everything needed to tell whether partial histograms belong to the same render
+struct HistogramHeader {
+    unsigned int width;
+    unsigned int height;
+
+    double minReal;
+    double minImag;
+    double cellWidth;
+
+    unsigned int iterations;
+    double power;
+    unsigned int anti;
+
+    unsigned int shardIndex;
+    unsigned int shardCount;
+
+    bool sameRender(const HistogramHeader &other) const;
+};
+
+// raw binary histogram, as written by each shard of a render. Reading is done a chunk at a time so that any
+// number of them can be summed while only holding the one histogram they are summed into
+class HistogramFile {
+private:
+    std::string fname;
+    std::ifstream input;
+
+public:
+    HistogramFile(std::string fname) : fname(fname) {};
+
+    int write(const Histogram *histogram, const RenderConfig &config);
+
+    // as above, to an already open stream rather than to fname
+    static int write(const Histogram *histogram, const RenderConfig &config, std::ostream *stream);
+
+    int open(HistogramHeader *header);
+    // returns how many counts were read into counts, up to its size, 0 once the file is finished
+    unsigned long int readChunk(std::vector<unsigned int> *counts);
+};
+
+#endif // HistogramFile_hpp
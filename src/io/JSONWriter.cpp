@@ -0,0 +1,72 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "JSONWriter.hpp"
+
+#include <fstream>
+#include <iostream>
+
+int JSONWriter::write(const Statistics *stats) {
+    std::ofstream stream;
+
+    stream.open(fname);
+
+    if (!stream)
+        return 1;
+
+    double escapeSeconds = stats->phase("escape");
+
+    stream << "{\n";
+    stream << "\t\"backend\": \"" << stats->backend << "\",\n";
+    stream << "\t\"wall_seconds\": " << stats->wallSeconds << ",\n";
+
+    stream << "\t\"phases\": {";
+    for (unsigned int i = 0; i < stats->phases.size(); ++i)
+        stream << (i == 0 ? "\n" : ",\n") << "\t\t\"" << stats->phases[i].first << "\": " << stats->phases[i].second;
+    stream << "\n\t},\n";
+
+    stream << "\t\"counters\": {\n";
+    stream << "\t\t\"orbits_evaluated\": " << stats->total.orbitsEvaluated << ",\n";
+    if (stats->iterationsTracked)
+        stream << "\t\t\"iterations_executed\": " << stats->total.iterationsExecuted << ",\n";
+    else
+        stream << "\t\t\"iterations_executed\": null,\n";
+    stream << "\t\t\"contributing_seeds\": " << stats->total.contributingSeeds << ",\n";
+    stream << "\t\t\"histogram_increments\": " << stats->total.histogramIncrements << ",\n";
+    if (stats->iterationsTracked)
+        stream << "\t\t\"cycles_found\": " << stats->total.cyclesFound << ",\n";
+    else
+        stream << "\t\t\"cycles_found\": null,\n";
+    stream << "\t\t\"kernel_launches\": " << stats->kernelLaunches << "\n";
+    stream << "\t},\n";
+
+    stream << "\t\"threads\": [";
+    for (unsigned int i = 0; i < stats->threads.size(); ++i) {
+        const ThreadCounters &t = stats->threads[i];
+        double idle = escapeSeconds > t.busySeconds ? escapeSeconds - t.busySeconds : 0.0;
+
+        stream << (i == 0 ? "\n" : ",\n") << "\t\t{ \"id\": " << i
+            << ", \"busy_seconds\": " << t.busySeconds
+            << ", \"idle_seconds\": " << idle
+            << ", \"orbits_evaluated\": " << t.orbitsEvaluated
+            << ", \"iterations_executed\": " << t.iterationsExecuted
+            << ", \"contributing_seeds\": " << t.contributingSeeds
+            << ", \"histogram_increments\": " << t.histogramIncrements
+            << ", \"cycles_found\": " << t.cyclesFound << " }";
+    }
+    stream << (stats->threads.empty() ? "]\n" : "\n\t]\n");
+
+    stream << "}\n";
+
+    stream.close();
+
+    std::cout << "Saved statistics to " << fname << std::endl;
+
+    return 0;
+}
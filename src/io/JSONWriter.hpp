@@ -0,0 +1,27 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "../Statistics.hpp"
+
+#include <string>
+
+#ifndef JSONWriter_hpp
+#define JSONWriter_hpp
+
+class JSONWriter {
+private:
+    std::string fname;
+
+public:
+    JSONWriter(std::string fname) : fname(fname) {};
+
+    int write(const Statistics *stats);
+};
+
+#endif // JSONWriter_hpp
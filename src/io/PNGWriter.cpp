@@ -9,74 +9,268 @@
 
 #include "PNGWriter.hpp"
 
-#include <opencv2/opencv.hpp>
+#include <zlib.h>
 
-#include <fstream>
+#include <algorithm>
 #include <iostream>
 #include <math.h>
+#include <thread>
 
-void PNGWriter::write(std::vector<std::vector<Cell*>>* fileData) {
-    cv::Mat image(windowWidth, windowWidth, CV_8UC4);
+static const unsigned char PNG_SIGNATURE[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
 
-    for (unsigned int i = 0; i < fileData->size(); ++i) {
-        for (unsigned int j = 0; j < fileData->size(); ++j) {
-            long double percentageOfMax = log(fileData->at(i)[j]->counter) / log(maxCount);
+// compressed bytes gathered before being written out as an IDAT chunk
+static const unsigned long int PNG_IDAT_SIZE = 1 << 16;
 
-            cv::Vec4b pixel;
+// zlib header for a 32KB window, which deflate streams of any compression level can sit behind
+static const unsigned char ZLIB_HEADER[2] = { 0x78, 0x9C };
 
-            if (percentageOfMax <= 0.25)
-                pixel = { 0, 0, 0, 255 };
-            else {
-                // rendering using brightness to determin alpha value but due to viewing videos,
-                // may appear weirdly washed out so for more consistent results, change rgb
-                // values and a set alpha by default
+// a stripe of rows, deflated on its own so that stripes can be compressed in parallel and then concatenated
+struct Stripe {
+    unsigned int firstRow;
+    unsigned int rows;
+    bool last;
 
-                if (alpha)
-                    pixel = { (unsigned char)colourR, (unsigned char)colourG, (unsigned char)colourB, (unsigned char)(percentageOfMax * 255.0f) };
-                else
-                    pixel = { (unsigned char)(colourR * percentageOfMax), (unsigned char)(colourG * percentageOfMax), (unsigned char)(colourB * percentageOfMax), 255 };
-            }
+    std::vector<unsigned char> compressed;
+    uLong adler;
+    int err;
+};
+
+static void putBigEndian(unsigned char *destination, unsigned int value) {
+    destination[0] = (value >> 24) & 0xFF;
+    destination[1] = (value >> 16) & 0xFF;
+    destination[2] = (value >> 8) & 0xFF;
+    destination[3] = value & 0xFF;
+}
+
+void PNGWriter::writeChunk(const char *type, const unsigned char *data, unsigned long int length) {
+    unsigned char header[8];
+    putBigEndian(header, (unsigned int)length);
+    std::copy(type, type + 4, header + 4);
+
+    // a NULL buffer resets crc32 rather than leaving it be, so empty chunks skip it
+    uLong crc = crc32(0L, header + 4, 4);
+    if (length != 0)
+        crc = crc32(crc, data, (uInt)length);
+
+    unsigned char footer[4];
+    putBigEndian(footer, (unsigned int)crc);
+
+    stream->write((const char*)header, sizeof(header));
+    stream->write((const char*)data, length);
+    stream->write((const char*)footer, sizeof(footer));
+}
+
+void PNGWriter::writeData(const unsigned char *data, unsigned long int length, bool last) {
+    pending.insert(pending.end(), data, data + length);
+
+    unsigned long int written = 0;
+
+    while (pending.size() - written >= PNG_IDAT_SIZE || (last && written < pending.size())) {
+        unsigned long int size = std::min(pending.size() - written, PNG_IDAT_SIZE);
+
+        writeChunk("IDAT", pending.data() + written, size);
+        written += size;
+    }
+
+    pending.erase(pending.begin(), pending.begin() + written);
+}
+
+unsigned long int PNGWriter::rowBytes(unsigned int width) const {
+    // a filter type byte, then every channel of every pixel
+    return 1 + (unsigned long int)width * (alpha ? 4 : 3) * (depth / 8);
+}
+
+template <class Image>
+void PNGWriter::colourRow(const Image *histogram, unsigned int row, unsigned char *pixels) const {
+    // 255 * 257 = 65535, so colours keep their full range at 16 bits
+    const unsigned int scale = depth == 16 ? 257 : 1;
+
+    unsigned char *pixel = pixels;
+    *pixel++ = 0; // no filtering
+
+    // samples are big endian
+    auto put = [&](unsigned int value) {
+        if (depth == 16)
+            *pixel++ = (unsigned char)(value >> 8);
 
-            image.at<cv::Vec4b>(cv::Point(j, i)) = pixel;
+        *pixel++ = (unsigned char)(value & 0xFF);
+    };
+
+    for (unsigned int j = 0; j < histogram->width; ++j) {
+        long double percentageOfMax = log(histogram->get(row, j)) / log(maxCount);
+
+        if (percentageOfMax <= 0.25) {
+            put(0);
+            put(0);
+            put(0);
+
+            if (alpha)
+                put(255 * scale);
+        } else if (alpha) {
+            // rendering using brightness to determin alpha value but due to viewing videos,
+            // may appear weirdly washed out so for more consistent results, change rgb
+            // values and a set alpha by default
+            put(colourR * scale);
+            put(colourG * scale);
+            put(colourB * scale);
+            put((unsigned int)(percentageOfMax * 255.0f * scale));
+        } else {
+            put((unsigned int)(colourR * scale * percentageOfMax));
+            put((unsigned int)(colourG * scale * percentageOfMax));
+            put((unsigned int)(colourB * scale * percentageOfMax));
         }
     }
+}
+
+int PNGWriter::write(const Histogram* histogram) {
+    std::ofstream file(fname, std::ios::binary);
+
+    if (!file || write(histogram, &file) != 0) {
+        std::cout << "Failed to save fractal to " << fname << std::endl;
+        return 1;
+    }
 
-    cv::cvtColor(image, image, cv::COLOR_RGB2BGR);
+    file.close();
 
-    cv::imwrite(fname, image);
+    if (!file) {
+        std::cout << "Failed to save fractal to " << fname << std::endl;
+        return 1;
+    }
 
     std::cout << "Saved fractal to " << fname << std::endl;
+
+    return 0;
+}
+
+int PNGWriter::write(const Histogram* histogram, std::ostream *out) {
+    return writeImage(histogram, out);
 }
 
-void PNGWriter::write(Real* fileData) {
-    cv::Mat image(windowWidth, windowWidth, CV_8UC4);
+int PNGWriter::write(const CountBlock &block, std::ostream *out) {
+    return writeImage(&block, out);
+}
 
-    for (unsigned int i = 0; i < windowWidth; ++i) {
-        for (unsigned int j = 0; j < windowWidth; ++j) {
-            long double percentageOfMax = log(fileData[i * cellsPerRow * 3 + j * 3 + 2]) / log(maxCount);
+template <class Image>
+int PNGWriter::writeImage(const Image *histogram, std::ostream *out) {
+    if (depth != 8 && depth != 16)
+        return 1;
 
-            cv::Vec4b pixel;
+    stream = out;
+    pending.clear();
 
-            if (percentageOfMax <= 0.25)
-                pixel = { 0, 0, 0, 255 };
-            else {
-                // rendering using brightness to determin alpha value but due to viewing videos,
-                // may appear weirdly washed out so for more consistent results, change rgb
-                // values and a set alpha by default
+    stream->write((const char*)PNG_SIGNATURE, sizeof(PNG_SIGNATURE));
 
-                if (alpha)
-                    pixel = { (unsigned char)colourR, (unsigned char)colourG, (unsigned char)colourB, (unsigned char)(percentageOfMax * 255.0f) };
-                else
-                    pixel = { (unsigned char)(colourR * percentageOfMax), (unsigned char)(colourG * percentageOfMax), (unsigned char)(colourB * percentageOfMax), 255 };
+    // truecolour with or without alpha, no interlacing
+    unsigned char header[13];
+    putBigEndian(header, histogram->width);
+    putBigEndian(header + 4, histogram->height);
+    header[8] = (unsigned char)depth;
+    header[9] = alpha ? 6 : 2;
+    header[10] = header[11] = header[12] = 0;
+
+    writeChunk("IHDR", header, sizeof(header));
+
+    const unsigned long int bytesPerRow = rowBytes(histogram->width);
+    const unsigned int stripeRows = (unsigned int)std::max(1UL, PNG_STRIPE_BYTES / bytesPerRow);
+    const unsigned int threads = std::max(numThreads, 1u);
+
+    // each stripe is a raw deflate stream ending on a byte boundary, from a sync flush, so they can be joined
+    // behind a single zlib header. Only the last stripe finishes the stream, and the adler32 of the image is
+    // combined from the stripes' own
+    auto compressStripe = [&](Stripe *stripe) {
+        std::vector<unsigned char> raw((unsigned long int)stripe->rows * bytesPerRow);
+
+        for (unsigned int i = 0; i < stripe->rows; ++i)
+            colourRow(histogram, stripe->firstRow + i, &raw[i * bytesPerRow]);
+
+        stripe->adler = adler32(adler32(0L, Z_NULL, 0), raw.data(), (uInt)raw.size());
+
+        z_stream deflater;
+        deflater.zalloc = Z_NULL;
+        deflater.zfree = Z_NULL;
+        deflater.opaque = Z_NULL;
+
+        stripe->err = deflateInit2(&deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+        if (stripe->err != Z_OK)
+            return;
+
+        // room for incompressible data and the flush's markers, growing in the unlikely case it is not enough
+        stripe->compressed.resize(deflateBound(&deflater, raw.size()) + 16);
+
+        deflater.next_in = raw.data();
+        deflater.avail_in = (uInt)raw.size();
+        deflater.next_out = stripe->compressed.data();
+        deflater.avail_out = (uInt)stripe->compressed.size();
+
+        const int flush = stripe->last ? Z_FINISH : Z_SYNC_FLUSH;
+
+        for (;;) {
+            stripe->err = deflate(&deflater, flush);
+
+            bool done = stripe->last ? stripe->err == Z_STREAM_END : deflater.avail_in == 0 && deflater.avail_out != 0;
+            if (done || (stripe->err != Z_OK && stripe->err != Z_BUF_ERROR))
+                break;
+
+            unsigned long int used = stripe->compressed.size() - deflater.avail_out;
+            stripe->compressed.resize(stripe->compressed.size() * 2);
+
+            deflater.next_out = stripe->compressed.data() + used;
+            deflater.avail_out = (uInt)(stripe->compressed.size() - used);
+        }
+
+        stripe->compressed.resize(stripe->compressed.size() - deflater.avail_out);
+        stripe->err = stripe->err == Z_STREAM_END || stripe->err == Z_OK ? Z_OK : stripe->err;
+
+        deflateEnd(&deflater);
+    };
+
+    writeData(ZLIB_HEADER, sizeof(ZLIB_HEADER), false);
+
+    uLong adler = adler32(0L, Z_NULL, 0);
+    int err = 0;
+
+    for (unsigned int firstRow = 0; err == 0 && firstRow < histogram->height;) {
+        std::vector<Stripe> stripes;
+
+        for (unsigned int i = 0; i < threads && firstRow < histogram->height; ++i) {
+            Stripe stripe;
+            stripe.firstRow = firstRow;
+            stripe.rows = std::min(stripeRows, histogram->height - firstRow);
+
+            firstRow += stripe.rows;
+            stripe.last = firstRow == histogram->height;
+
+            stripes.push_back(stripe);
+        }
+
+        std::vector<std::thread> workers;
+
+        for (unsigned int i = 1; i < stripes.size(); ++i)
+            workers.push_back(std::thread(compressStripe, &stripes[i]));
+
+        compressStripe(&stripes[0]);
+
+        for (std::thread &worker : workers)
+            worker.join();
+
+        for (Stripe &stripe : stripes) {
+            if (stripe.err != Z_OK) {
+                err = 1;
+                break;
             }
 
-            image.at<cv::Vec4b>(cv::Point(j, i)) = pixel;
+            writeData(stripe.compressed.data(), stripe.compressed.size(), false);
+            adler = adler32_combine(adler, stripe.adler, (z_off_t)stripe.rows * bytesPerRow);
         }
+
+        histogram->flushRows(stripes.front().firstRow, firstRow - stripes.front().firstRow);
     }
 
-    cv::cvtColor(image, image, cv::COLOR_RGB2BGR);
+    unsigned char trailer[4];
+    putBigEndian(trailer, (unsigned int)adler);
+    writeData(trailer, sizeof(trailer), true);
 
-    cv::imwrite(fname, image);
+    writeChunk("IEND", NULL, 0);
 
-    std::cout << "Saved fractal to " << fname << std::endl;
+    return err != 0 || !*stream ? 1 : 0;
 }
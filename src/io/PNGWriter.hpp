@@ -7,39 +7,68 @@
 ///
 //===========================================================================//
 
-#include "../Cell.hpp"
+#include "../Histogram.hpp"
 
+#include <fstream>
 #include <string>
+#include <vector>
 
 #ifndef PNGWriter_hpp
 #define PNGWriter_hpp
 
-#if DOUBLE_SUPPORT_AVAILABLE
-    // double
-typedef double Real;
-#else
-    // float
-typedef float Real;
-#endif
+// raw image bytes that each thread colours and compresses at a time
+static const unsigned long int PNG_STRIPE_BYTES = 1 << 20;
+
+// counts held in memory, row after row, standing in for a histogram, e.g a tile of a pyramid whose counts have
+// been summed from several pixels of the histogram so may not fit in its unsigned ints
+struct CountBlock {
+    unsigned int width;
+    unsigned int height;
+    const unsigned long long *counts;
+
+    inline unsigned long long get(unsigned int row, unsigned int column) const { return counts[(unsigned long int)row * width + column]; };
+    void flushRows(unsigned int, unsigned int) const {};
+};
 
 class PNGWriter {
 private:
     std::string fname;
 
-    unsigned int windowWidth,
-        cellsPerRow,
-        colourR,
+    unsigned int colourR,
         colourG,
-        colourB,
-        maxCount;
+        colourB;
+    unsigned long long maxCount;
 
     bool alpha;
+    unsigned int depth; // bits per channel, 8 or 16
+    unsigned int numThreads;
+
+    std::ostream *stream;
+    std::vector<unsigned char> pending; // compressed bytes not yet written out as an IDAT chunk
+
+    void writeChunk(const char *type, const unsigned char *data, unsigned long int length);
+    void writeData(const unsigned char *data, unsigned long int length, bool last);
+
+    unsigned long int rowBytes(unsigned int width) const;
+
+    // Image is a Histogram or a CountBlock
+    template <class Image>
+    void colourRow(const Image *image, unsigned int row, unsigned char *pixels) const;
+
+    template <class Image>
+    int writeImage(const Image *image, std::ostream *out);
 
 public:
-    PNGWriter(std::string fname, unsigned int windowWidth, unsigned int cellsPerRow, unsigned int colourR, unsigned int colourG, unsigned int colourB, unsigned int maxCount, bool alpha) : fname(fname), windowWidth(windowWidth), cellsPerRow(cellsPerRow), colourR(colourR), colourG(colourG), colourB(colourB), maxCount(maxCount), alpha(alpha) {};
+    PNGWriter(std::string fname, unsigned int colourR, unsigned int colourG, unsigned int colourB, unsigned long long maxCount, bool alpha, unsigned int depth = 8, unsigned int numThreads = 1) : fname(fname), colourR(colourR), colourG(colourG), colourB(colourB), maxCount(maxCount), alpha(alpha), depth(depth), numThreads(numThreads), stream(NULL) {};
+
+    // one pixel per histogram cell, rows of the histogram becoming rows of the image. Stripes of rows are
+    // coloured and compressed by numThreads threads at once, a round of stripes at a time, so the image is never
+    // held in memory and a file-backed histogram is only read through once
+    int write(const Histogram* histogram);
 
-    void write(std::vector<std::vector<Cell*>>* fileData);
-    void write(Real* fileData);
+    // as above, to an already open stream rather than to fname
+    int write(const Histogram* histogram, std::ostream *out);
+    int write(const CountBlock &block, std::ostream *out);
 };
 
 #endif // PNGWriter_hpp
@@ -0,0 +1,197 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "PyramidWriter.hpp"
+
+#ifdef _WIN32
+    #include <direct.h>
+#else
+    #include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+static bool makeDirectory(const std::string &path) {
+#ifdef _WIN32
+    return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+template <class Image>
+unsigned long long PyramidWriter::tile(unsigned int level, const Image *image, unsigned int rowOffset, unsigned int firstRow, unsigned int rows, unsigned int tileColumn, int *failed) {
+    const Level &current = levels[level];
+    Level *below = level > 0 ? &levels[level - 1] : NULL;
+
+    const unsigned int firstColumn = tileColumn * PYRAMID_TILE_SIZE;
+    const unsigned int columns = std::min(PYRAMID_TILE_SIZE, current.width - firstColumn);
+
+    std::vector<unsigned long long> counts(writing ? (unsigned long int)rows * columns : 0);
+    unsigned long long brightest = 0;
+
+    for (unsigned int i = 0; i < rows; ++i) {
+        const unsigned int row = firstRow + i;
+        unsigned long long *summed = below ? &below->band[(unsigned long int)((row >> 1) - below->bandRow) * below->width] : NULL;
+
+        for (unsigned int j = 0; j < columns; ++j) {
+            const unsigned int column = firstColumn + j;
+            const unsigned long long count = image->get(row - rowOffset, column);
+
+            brightest = std::max(brightest, count);
+
+            if (writing)
+                counts[(unsigned long int)i * columns + j] = count;
+
+            // tiles are an even number of pixels wide, so no two tiles sum into the same pixel below
+            if (summed)
+                summed[column >> 1] += count;
+        }
+    }
+
+    if (writing) {
+        const std::string path = fname + "_files/" + std::to_string(level) + "/" + std::to_string(tileColumn) + "_" + std::to_string(firstRow / PYRAMID_TILE_SIZE) + ".png";
+
+        std::ofstream file(path, std::ios::binary);
+        PNGWriter picture(path, colourR, colourG, colourB, current.maxCount, alpha, depth);
+
+        CountBlock block = { columns, rows, counts.data() };
+
+        if (!file || picture.write(block, &file) != 0)
+            *failed = 1;
+
+        file.close();
+
+        if (!file)
+            *failed = 1;
+    }
+
+    return brightest;
+}
+
+template <class Image>
+void PyramidWriter::flushBand(unsigned int level, const Image *image, unsigned int rowOffset, unsigned int firstRow, unsigned int rows) {
+    Level &current = levels[level];
+
+    const unsigned int tileColumns = (current.width + PYRAMID_TILE_SIZE - 1) / PYRAMID_TILE_SIZE;
+    const unsigned int threads = std::min(std::max(numThreads, 1u), tileColumns);
+
+    std::vector<unsigned long long> brightest(threads, 0);
+    std::vector<int> failed(threads, 0);
+
+    auto work = [&](unsigned int thread) {
+        for (unsigned int tileColumn = thread; tileColumn < tileColumns; tileColumn += threads)
+            brightest[thread] = std::max(brightest[thread], tile(level, image, rowOffset, firstRow, rows, tileColumn, &failed[thread]));
+    };
+
+    std::vector<std::thread> workers;
+
+    for (unsigned int i = 1; i < threads; ++i)
+        workers.push_back(std::thread(work, i));
+
+    work(0);
+
+    for (std::thread &worker : workers)
+        worker.join();
+
+    for (unsigned int i = 0; i < threads; ++i) {
+        current.maxCount = std::max(current.maxCount, brightest[i]);
+        err |= failed[i];
+    }
+
+    if (level == 0)
+        return;
+
+    // the level below is only passed on once it has a whole band, or its last rows
+    Level &below = levels[level - 1];
+    const unsigned int summedRows = (firstRow + rows + 1) / 2 - below.bandRow;
+
+    if (summedRows == PYRAMID_TILE_SIZE || below.bandRow + summedRows == below.height) {
+        CountBlock block = { below.width, summedRows, below.band.data() };
+        flushBand(level - 1, &block, below.bandRow, below.bandRow, summedRows);
+
+        below.bandRow += summedRows;
+        std::fill(below.band.begin(), below.band.end(), 0);
+    }
+}
+
+void PyramidWriter::pass(const Histogram *histogram, bool writing) {
+    this->writing = writing;
+
+    for (unsigned int level = 0; level + 1 < levels.size(); ++level) {
+        levels[level].band.assign((unsigned long int)PYRAMID_TILE_SIZE * levels[level].width, 0);
+        levels[level].bandRow = 0;
+    }
+
+    // the histogram is its own band, so is read straight from rather than copied
+    const unsigned int top = (unsigned int)levels.size() - 1;
+
+    for (unsigned int firstRow = 0; err == 0 && firstRow < histogram->height; firstRow += PYRAMID_TILE_SIZE) {
+        const unsigned int rows = std::min(PYRAMID_TILE_SIZE, histogram->height - firstRow);
+
+        flushBand(top, histogram, 0, firstRow, rows);
+        histogram->flushRows(firstRow, rows);
+    }
+
+    for (Level &level : levels)
+        std::vector<unsigned long long>().swap(level.band);
+}
+
+int PyramidWriter::write(const Histogram *histogram) {
+    if (histogram->width == 0 || histogram->height == 0 || (depth != 8 && depth != 16)) {
+        std::cout << "Failed to save fractal to " << fname << ".dzi" << std::endl;
+        return 1;
+    }
+
+    // levels halve, rounding up, until the image is a single pixel
+    levels.clear();
+
+    for (unsigned int width = histogram->width, height = histogram->height;; width = (width + 1) / 2, height = (height + 1) / 2) {
+        Level level;
+        level.width = width;
+        level.height = height;
+        level.maxCount = 0;
+        level.bandRow = 0;
+
+        levels.insert(levels.begin(), level);
+
+        if (width == 1 && height == 1)
+            break;
+    }
+
+    err = makeDirectory(fname + "_files") ? 0 : 1;
+    for (unsigned int level = 0; err == 0 && level < levels.size(); ++level)
+        err = makeDirectory(fname + "_files/" + std::to_string(level)) ? 0 : 1;
+
+    if (err == 0)
+        pass(histogram, false);
+
+    if (err == 0)
+        pass(histogram, true);
+
+    std::ofstream descriptor(fname + ".dzi");
+    descriptor << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"png\" Overlap=\"0\" TileSize=\"" << PYRAMID_TILE_SIZE << "\">\n"
+        << "    <Size Width=\"" << histogram->width << "\" Height=\"" << histogram->height << "\"/>\n"
+        << "</Image>\n";
+    descriptor.close();
+
+    if (err != 0 || !descriptor) {
+        std::cout << "Failed to save fractal to " << fname << ".dzi" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Saved fractal to " << fname << ".dzi, in " << levels.size() << " levels of tiles" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "../Histogram.hpp"
+#include "PNGWriter.hpp"
+
+#include <string>
+#include <vector>
+
+#ifndef PyramidWriter_hpp
+#define PyramidWriter_hpp
+
+// width and height of every tile, and of the bands of rows that each level is streamed through
+static const unsigned int PYRAMID_TILE_SIZE = 256;
+
+// writes the histogram as a Deep Zoom pyramid, fname + ".dzi" describing the image and fname + "_files/LEVEL/"
+// holding its COLUMN_ROW.png tiles. Each level halves the one above, down to a single pixel, a pixel of the smaller
+// level being the sum of the counts of the 2x2 pixels it covers. Every level is tone mapped from its summed counts
+// against its own brightest pixel, so faint regions that only show once enough of their pixels are summed are kept
+// rather than averaged away.
+// The histogram is read through a band of tile rows at a time, twice: once to find each level's brightest pixel and
+// once to write the tiles. Each level only keeps the band it is summing into, so a file-backed histogram is never
+// held in memory whole
+class PyramidWriter {
+private:
+    std::string fname;
+
+    unsigned int colourR,
+        colourG,
+        colourB;
+
+    bool alpha;
+    unsigned int depth; // bits per channel, 8 or 16
+    unsigned int numThreads;
+
+    struct Level {
+        unsigned int width;
+        unsigned int height;
+        unsigned long long maxCount;
+
+        std::vector<unsigned long long> band; // rows summed from the level above, PYRAMID_TILE_SIZE at most
+        unsigned int bandRow;                  // row of the level that band starts at
+    };
+
+    std::vector<Level> levels; // the single pixel first, the histogram itself last
+    bool writing;              // false while only finding each level's brightest pixel
+    int err;
+
+    // the tile at tileColumn of the rows from firstRow of level, whose row r is row r - rowOffset of image. Adds
+    // every count to the band of the level below and, when writing, saves the tile, setting failed if it could not
+    // be. Returns the tile's brightest pixel
+    template <class Image>
+    unsigned long long tile(unsigned int level, const Image *image, unsigned int rowOffset, unsigned int firstRow, unsigned int rows, unsigned int tileColumn, int *failed);
+
+    // every tile of the band, split between numThreads threads, then the level below once its band is complete
+    template <class Image>
+    void flushBand(unsigned int level, const Image *image, unsigned int rowOffset, unsigned int firstRow, unsigned int rows);
+
+    void pass(const Histogram *histogram, bool writing);
+
+public:
+    PyramidWriter(std::string fname, unsigned int colourR, unsigned int colourG, unsigned int colourB, bool alpha, unsigned int depth = 8, unsigned int numThreads = 1) : fname(fname), colourR(colourR), colourG(colourG), colourB(colourB), alpha(alpha), depth(depth), numThreads(numThreads), writing(false), err(0) {};
+
+    int write(const Histogram *histogram);
+};
+
+#endif // PyramidWriter_hpp
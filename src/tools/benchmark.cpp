@@ -0,0 +1,174 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "../OpenCLKernelHelper.hpp"
+#include "../Options.hpp"
+#include "../Renderer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void showBenchmarkUsage(std::string name) {
+    std::cerr << "Usage: " << name << " <option(s)> [-- RENDER_OPTION(S)]\n"
+        << "Renders the same buddhabrot through the OpenCL kernel in every precision the device has, and reports\n"
+        << "how long each took and how far its histogram is from a long double render on the CPU. RENDER_OPTIONS\n"
+        << "are the same as for buddhabrot itself, --device choosing the device, e.g a CPU OpenCL runtime\n"
+        << "Options:\n"
+        << "\t-h\n\t\t Show this help message\n\n"
+        << "\t-l\n\t\t List the OpenCL devices, in the order --device counts them\n\n"
+        << "\t-r REPEATS\n\t\t Render each precision this many times, reporting the fastest\n\t\t defaults to 3\n\n"
+        << "\t-n\n\t\t Skip the CPU render, and so the accuracy columns\n"
+        << std::endl;
+}
+
+// renders config repeats times, keeping the histogram and statistics of the fastest render
+static int renderFastest(const RenderConfig &config, unsigned int repeats, std::vector<unsigned int> *counts, double *seconds, double *kernelSeconds, unsigned long long *increments) {
+    *seconds = -1;
+
+    for (unsigned int r = 0; r < repeats; ++r) {
+        Renderer renderer(config);
+        if (renderer.render() != 0)
+            return 1;
+
+        Statistics *stats = renderer.getStatistics();
+        if (*seconds >= 0 && stats->wallSeconds >= *seconds)
+            continue;
+
+        *seconds = stats->wallSeconds;
+        *kernelSeconds = stats->phase("check") + stats->phase("count");
+        *increments = stats->total.histogramIncrements;
+
+        const Histogram &histogram = renderer.getHistogram();
+        counts->resize(histogram.size());
+
+        for (unsigned int i = 0; i < histogram.height; ++i) {
+            for (unsigned int j = 0; j < histogram.width; ++j)
+                (*counts)[(unsigned long int)i * histogram.width + j] = histogram.get(i, j);
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned int repeats = 3;
+    bool reference = true;
+
+    int i = 1;
+
+    for (; i < argc && std::string(argv[i]) != "--"; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-l") {
+            std::vector<std::string> devices = OpenCLKernelHelper::devices();
+
+            for (unsigned int d = 0; d < devices.size(); ++d)
+                std::cout << d << '\t' << devices[d] << std::endl;
+
+            if (devices.empty())
+                std::cout << "No OpenCL devices found" << std::endl;
+
+            return 0;
+        } else if (arg == "-r" && i + 1 < argc) {
+            repeats = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-n") {
+            reference = false;
+        } else {
+            showBenchmarkUsage(argv[0]);
+            return arg == "-h" ? -1 : 1;
+        }
+    }
+
+    Options options;
+    if (i < argc && parseOptions(std::vector<std::string>(argv + i + 1, argv + argc), &options) != 0) {
+        showBenchmarkUsage(argv[0]);
+        return 1;
+    }
+
+    RenderConfig config = options.config;
+    config.useGpu = false;
+    config.cacheDir.clear(); // every render has to find the contributing seeds for itself
+
+    std::vector<unsigned int> expected;
+    double seconds = 0, kernelSeconds = 0;
+    unsigned long long increments = 0;
+
+    if (reference) {
+        std::cout << "Rendering the long double reference on the CPU" << std::endl;
+
+        if (renderFastest(config, 1, &expected, &seconds, &kernelSeconds, &increments) != 0)
+            return 1;
+    }
+
+    config.useGpu = true;
+
+    OpenCLKernelHelper *helper = OpenCLKernelHelper::shared(config.device);
+
+    struct Result {
+        KernelPrecision precision;
+        double seconds;
+        double kernelSeconds;
+        unsigned long long increments;
+        double difference;  // sum of |count - expected| over the sum of expected
+        double pixelsOff;   // fraction of pixels whose count differs at all
+    };
+
+    std::vector<Result> results;
+
+    const KernelPrecision precisions[3] = { PRECISION_FLOAT, PRECISION_FLOAT_FLOAT, PRECISION_DOUBLE };
+
+    for (KernelPrecision precision : precisions) {
+        if (helper->resolvePrecision(precision) != precision) {
+            std::cout << "Skipping " << precisionName(precision) << ", which the device does not have" << std::endl;
+            continue;
+        }
+
+        config.precision = precision;
+
+        std::vector<unsigned int> counts;
+        Result result = { precision, 0, 0, 0, 0, 0 };
+
+        if (renderFastest(config, repeats, &counts, &result.seconds, &result.kernelSeconds, &result.increments) != 0)
+            return 1;
+
+        if (reference && counts.size() == expected.size()) {
+            unsigned long long total = 0, difference = 0, off = 0;
+
+            for (unsigned long int k = 0; k < counts.size(); ++k) {
+                total += expected[k];
+                difference += counts[k] > expected[k] ? counts[k] - expected[k] : expected[k] - counts[k];
+                off += counts[k] != expected[k];
+            }
+
+            result.difference = total != 0 ? (double)difference / total : 0;
+            result.pixelsOff = counts.empty() ? 0 : (double)off / counts.size();
+        }
+
+        results.push_back(result);
+    }
+
+    printf("\n%-12s %10s %12s %16s %12s %12s\n", "precision", "wall s", "kernel s", "increments/s", "difference", "pixels off");
+
+    if (reference)
+        printf("%-12s %10.3f %12s %16.4g %12s %12s\n", "cpu", seconds, "N/A", seconds > 0 ? increments / seconds : 0.0, "0", "0");
+
+    for (const Result &result : results) {
+        printf("%-12s %10.3f %12.3f %16.4g", precisionName(result.precision), result.seconds, result.kernelSeconds, result.kernelSeconds > 0 ? result.increments / result.kernelSeconds : 0.0);
+
+        if (reference)
+            printf(" %11.4g%% %11.4g%%\n", result.difference * 100, result.pixelsOff * 100);
+        else
+            printf(" %12s %12s\n", "N/A", "N/A");
+    }
+
+    return 0;
+}
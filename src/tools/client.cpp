@@ -0,0 +1,213 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void showUsage(std::string name) {
+    std::cerr << "Usage: " << name << " <option(s)> SOCKET [RENDER_OPTION(S)]\n"
+        << "Sends render requests to a buddhabrot --serve SOCKET and reports their latency. RENDER_OPTIONS are the\n"
+        << "same as for buddhabrot itself\n"
+        << "Options:\n"
+        << "\t-h\n\t\t Show this help message\n\n"
+        << "\t-f FORMAT\n\t\t Ask for a png or a binary histogram, hist\n\t\t defaults to png\n\n"
+        << "\t-c CONNECTIONS\n\t\t Send requests over this many connections at once\n\t\t defaults to 1\n\n"
+        << "\t-n REQUESTS\n\t\t Send this many requests, one after another, over each connection\n\t\t defaults to 1\n\n"
+        << "\t-o FILE_NAME\n\t\t Save the first response to FILE_NAME\n\t\t defaults to not save\n\n"
+        << "\t-x\n\t\t Ask the server to shut down once every request has been answered\n"
+        << std::endl;
+}
+
+static int connectTo(const std::string &socketName) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketName.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd >= 0 && connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// sends a request line and reads its whole response, returning 0 on OK
+static int request(int fd, const std::string &line, std::string *body) {
+    std::string message = line + '\n';
+
+    for (size_t sent = 0; sent < message.size();) {
+        ssize_t length = send(fd, message.data() + sent, message.size() - sent, 0);
+        if (length <= 0)
+            return 1;
+
+        sent += length;
+    }
+
+    std::string header;
+    char c;
+
+    while (recv(fd, &c, 1, 0) == 1 && c != '\n')
+        header += c;
+
+    if (header.compare(0, 3, "OK ") != 0) {
+        std::cerr << (header.empty() ? "No response" : header) << std::endl;
+        return 1;
+    }
+
+    body->resize(std::stoul(header.substr(3)));
+
+    for (size_t received = 0; received < body->size();) {
+        ssize_t length = recv(fd, &(*body)[received], body->size() - received, 0);
+        if (length <= 0)
+            return 1;
+
+        received += length;
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string format = "png";
+    std::string saveFileName;
+    unsigned int connections = 1, requests = 1;
+    bool shutdownAfter = false;
+
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-f" && i + 1 < argc) {
+            format = argv[++i];
+        } else if (arg == "-c" && i + 1 < argc) {
+            connections = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-n" && i + 1 < argc) {
+            requests = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-o" && i + 1 < argc) {
+            saveFileName = argv[++i];
+        } else if (arg == "-x") {
+            shutdownAfter = true;
+        } else {
+            showUsage(argv[0]);
+            return arg == "-h" ? -1 : 1;
+        }
+    }
+
+    if (i >= argc) {
+        showUsage(argv[0]);
+        return 1;
+    }
+
+    const std::string socketName = argv[i++];
+
+    // the render's options are passed on as one line, quoting any that contain spaces
+    std::string line = format;
+
+    for (; i < argc; ++i) {
+        std::string arg = argv[i];
+        line += ' ' + (arg.find(' ') == std::string::npos ? arg : '"' + arg + '"');
+    }
+
+    std::vector<double> latencies;
+    unsigned int failures = 0;
+    bool saved = false;
+
+    std::mutex mutex;
+    std::vector<std::thread> workers;
+
+    auto work = [&]() {
+        int fd = connectTo(socketName);
+
+        if (fd < 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::cerr << "Failed to connect to " << socketName << std::endl;
+            failures += requests;
+            return;
+        }
+
+        for (unsigned int n = 0; n < requests; ++n) {
+            std::string body;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            int err = request(fd, line, &body);
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (err != 0) {
+                ++failures;
+                continue;
+            }
+
+            latencies.push_back(milliseconds);
+
+            if (!saveFileName.empty() && !saved) {
+                std::ofstream file(saveFileName, std::ios::binary);
+                file.write(body.data(), body.size());
+                saved = true;
+            }
+        }
+
+        close(fd);
+    };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (unsigned int c = 0; c < connections; ++c)
+        workers.push_back(std::thread(work));
+
+    for (std::thread &worker : workers)
+        worker.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+
+        double total = 0;
+        for (double latency : latencies)
+            total += latency;
+
+        printf("%zu requests in %.3fs, %.1f per second\n", latencies.size(), seconds, latencies.size() / seconds);
+        printf("latency (ms) min %.2f, mean %.2f, p50 %.2f, p95 %.2f, max %.2f\n", latencies.front(), total / latencies.size(),
+            latencies[latencies.size() / 2], latencies[std::min(latencies.size() - 1, latencies.size() * 95 / 100)], latencies.back());
+    }
+
+    if (failures != 0)
+        printf("%u requests failed\n", failures);
+
+    if (shutdownAfter) {
+        int fd = connectTo(socketName);
+        std::string body;
+
+        if (fd < 0 || request(fd, "shutdown", &body) != 0)
+            std::cerr << "Failed to shut down the server" << std::endl;
+
+        if (fd >= 0)
+            close(fd);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
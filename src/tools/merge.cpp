@@ -0,0 +1,150 @@
+//===========================================================================//
+///
+/// Copyright Jim Carty © 2021
+///
+/// This file is subject to the terms and conditions defined in file
+/// 'LICENSE.txt', which is part of this source code package.
+///
+//===========================================================================//
+
+#include "../Histogram.hpp"
+#include "../io/CSVReader.hpp"
+#include "../io/HistogramFile.hpp"
+#include "../io/PNGWriter.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// counts read from a partial histogram at a time
+static const unsigned long int MERGE_CHUNK = 1 << 20;
+
+static void showUsage(std::string name) {
+    std::cerr << "Usage: " << name << " <option(s)> PARTIAL.hist...\n"
+        << "Sums the partial histograms written by buddhabrot --shard into one render\n"
+        << "Options:\n"
+        << "\t-h\n\t\t Show this help message\n\n"
+        << "\t-4\n\t\t Generate png with alpha based-brightness; viewer dependant\n\t\t defaults to false\n\n"
+        << "\t-s FILE_NAME\n\t\t Saves buddhabrot as a png and csv to the specified\n\t\t (FILE_NAME + '.png'/'.csv')\n\t\t defaults to 'buddhabrot'\n\n"
+        << "\t-c COLOUR_R,COLOUR_G,COLOUR_B\n\t\t Specify the render's colour\n\t\t defaults to 0,0,255\n\n"
+        << "\t-d BITS\n\t\t Save the png with 8 or 16 bits per channel\n\t\t defaults to 8\n\n"
+        << "\t-m MEGABYTES\n\t\t Keep the merged histogram within MEGABYTES of memory, backing it\n\t\t with a temporary file when it is larger\n\t\t defaults to no limit\n"
+        << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string saveFileName = "buddhabrot";
+    unsigned int colourR = 0, colourG = 0, colourB = 255;
+    bool alpha = false;
+    unsigned int depth = 8;
+    unsigned long long maxMemory = 0;
+
+    std::vector<std::string> partials;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-h") {
+            showUsage(argv[0]);
+            return -1;
+        } else if (arg == "-4") {
+            alpha = true;
+        } else if (arg == "-s" && i + 1 < argc) {
+            saveFileName = argv[++i];
+        } else if (arg == "-c" && i + 1 < argc) {
+            std::stringstream lineStream(argv[++i]);
+            std::string tmp;
+
+            std::getline(lineStream, tmp, ',');
+            colourR = std::stoi(tmp);
+            std::getline(lineStream, tmp, ',');
+            colourG = std::stoi(tmp);
+            std::getline(lineStream, tmp, ',');
+            colourB = std::stoi(tmp);
+        } else if (arg == "-d" && i + 1 < argc) {
+            depth = std::stoi(argv[++i]);
+        } else if (arg == "-m" && i + 1 < argc) {
+            maxMemory = std::stoull(argv[++i]) << 20;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            printf("Unknown option: %s\n", arg.c_str());
+            showUsage(argv[0]);
+            return 1;
+        } else
+            partials.push_back(arg);
+    }
+
+    if (partials.empty()) {
+        showUsage(argv[0]);
+        return 1;
+    }
+
+    Histogram histogram;
+    HistogramHeader first;
+    std::vector<bool> shardsSeen;
+
+    std::vector<unsigned int> chunk(MERGE_CHUNK);
+
+    for (const std::string &fileName : partials) {
+        HistogramFile partial(fileName);
+        HistogramHeader header;
+
+        if (partial.open(&header) != 0) {
+            std::cout << "Failed to read partial histogram " << fileName << std::endl;
+            return 1;
+        }
+
+        if (!histogram.allocated()) {
+            first = header;
+            shardsSeen.assign(header.shardCount, false);
+
+            histogram.allocate(header.width, header.height, header.minReal, header.minImag, header.cellWidth, maxMemory);
+        } else if (!header.sameRender(first)) {
+            std::cout << fileName << " is not part of the same render as " << partials[0] << std::endl;
+            return 1;
+        }
+
+        if (header.shardIndex >= shardsSeen.size() || shardsSeen[header.shardIndex]) {
+            std::cout << fileName << " repeats shard " << header.shardIndex << '/' << header.shardCount << std::endl;
+            return 1;
+        }
+
+        shardsSeen[header.shardIndex] = true;
+
+        unsigned long int position = 0;
+        unsigned long int read;
+
+        while (position < histogram.size() && (read = partial.readChunk(&chunk)) != 0) {
+            for (unsigned long int i = 0; i < read && position < histogram.size(); ++i, ++position) {
+                if (chunk[i] != 0)
+                    histogram.add(position, chunk[i]);
+            }
+        }
+
+        if (position != histogram.size()) {
+            std::cout << fileName << " is truncated" << std::endl;
+            return 1;
+        }
+
+        std::cout << "Merged shard " << header.shardIndex << '/' << header.shardCount << " from " << fileName << std::endl;
+    }
+
+    unsigned int missing = 0;
+    for (bool seen : shardsSeen)
+        missing += !seen;
+
+    if (missing != 0)
+        std::cout << "Warning: " << missing << " of " << shardsSeen.size() << " shards are missing, the render will be incomplete" << std::endl;
+
+    unsigned int maxCount = histogram.maxCount();
+    std::cout << "Max count := " << maxCount << std::endl;
+
+    PNGWriter picture(saveFileName + ".png", colourR, colourG, colourB, maxCount, alpha, depth, std::max(std::thread::hardware_concurrency(), 1u));
+    if (picture.write(&histogram) != 0)
+        return 1;
+
+    CSVReader csv(saveFileName + ".csv");
+    return csv.write(&histogram);
+}
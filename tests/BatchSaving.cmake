@@ -0,0 +1,31 @@
+# batch jobs that share a histogram but differ in --png-depth or --pyramid, each of which has to be saved its own
+# way. Ran by ctest with BUDDHABROT as the path of the executable and WORK_DIR as somewhere to write to
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+file(WRITE ${WORK_DIR}/saving.batch
+    "-w 64 -i 50 -s eight\n"
+    "-w 64 -i 50 --png-depth 16 -s sixteen\n"
+    "-w 64 -i 50 --pyramid -s tiles\n")
+
+execute_process(COMMAND ${BUDDHABROT} --batch saving.batch WORKING_DIRECTORY ${WORK_DIR} RESULT_VARIABLE result OUTPUT_QUIET)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "Batch failed with ${result}")
+endif ()
+
+# the bit depth is the 25th byte of a png, inside of its IHDR chunk
+function(expect_depth name expected)
+    file(READ ${WORK_DIR}/${name}.png depth OFFSET 24 LIMIT 1 HEX)
+
+    if (NOT depth STREQUAL expected)
+        message(FATAL_ERROR "${name}.png has a bit depth of 0x${depth} rather than 0x${expected}")
+    endif ()
+endfunction()
+
+expect_depth(eight 08)
+expect_depth(sixteen 10)
+
+if (NOT EXISTS ${WORK_DIR}/tiles.dzi OR NOT EXISTS ${WORK_DIR}/tiles_files/0/0_0.png OR EXISTS ${WORK_DIR}/tiles.png)
+    message(FATAL_ERROR "tiles was not saved as a pyramid")
+endif ()